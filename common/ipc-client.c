@@ -11,8 +11,6 @@
 
 static const char ipc_magic[] = {'i', '3', '-', 'i', 'p', 'c'};
 
-#define IPC_HEADER_SIZE (sizeof(ipc_magic) + 8)
-
 char *get_socketpath(void) {
 	const char *swaysock = getenv("SWAYSOCK");
 	if (swaysock) {
@@ -128,19 +126,38 @@ void free_ipc_response(struct ipc_response *response) {
 	free(response);
 }
 
-char *ipc_single_command(int socketfd, uint32_t type, const char *payload, uint32_t *len) {
+bool ipc_parse_header(const char *header, uint32_t *size, uint32_t *type) {
+	if (memcmp(header, ipc_magic, sizeof(ipc_magic)) != 0) {
+		return false;
+	}
+	memcpy(size, header + sizeof(ipc_magic), sizeof(*size));
+	memcpy(type, header + sizeof(ipc_magic) + sizeof(*size), sizeof(*type));
+	return true;
+}
+
+bool ipc_send_message(int socketfd, uint32_t type, const char *payload,
+		uint32_t len) {
 	char data[IPC_HEADER_SIZE];
 	uint32_t *data32 = (uint32_t *)(data + sizeof(ipc_magic));
 	memcpy(data, ipc_magic, sizeof(ipc_magic));
-	memcpy(&data32[0], len, sizeof(*len));
+	memcpy(&data32[0], &len, sizeof(len));
 	memcpy(&data32[1], &type, sizeof(type));
 
 	if (write(socketfd, data, IPC_HEADER_SIZE) == -1) {
-		sway_abort("Unable to send IPC header");
+		sway_log_errno(SWAY_ERROR, "Unable to send IPC header");
+		return false;
 	}
 
-	if (write(socketfd, payload, *len) == -1) {
-		sway_abort("Unable to send IPC payload");
+	if (write(socketfd, payload, len) == -1) {
+		sway_log_errno(SWAY_ERROR, "Unable to send IPC payload");
+		return false;
+	}
+	return true;
+}
+
+char *ipc_single_command(int socketfd, uint32_t type, const char *payload, uint32_t *len) {
+	if (!ipc_send_message(socketfd, type, payload, *len)) {
+		sway_abort("Unable to send IPC message");
 	}
 
 	struct ipc_response *resp = ipc_recv_response(socketfd);
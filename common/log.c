@@ -1,6 +1,9 @@
 #define _POSIX_C_SOURCE 199506L
+#include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -14,6 +17,7 @@ void _sway_abort(const char *format, ...) {
 	va_start(args, format);
 	_sway_vlog(SWAY_ERROR, format, args);
 	va_end(args);
+	sway_log_flush();
 	log_terminate(EXIT_FAILURE);
 }
 
@@ -28,6 +32,7 @@ bool _sway_assert(bool condition, const char *format, ...) {
 	va_end(args);
 
 #ifndef NDEBUG
+	sway_log_flush();
 	raise(SIGABRT);
 #endif
 
@@ -35,7 +40,8 @@ bool _sway_assert(bool condition, const char *format, ...) {
 }
 
 static bool colored = true;
-static sway_log_importance_t log_importance = SWAY_ERROR;
+static bool stderr_is_tty = false;
+sway_log_importance_t _sway_log_importance = SWAY_ERROR;
 
 static const char *verbosity_colors[] = {
 	[SWAY_SILENT] = "",
@@ -44,53 +50,271 @@ static const char *verbosity_colors[] = {
 	[SWAY_DEBUG ] = "\x1B[1;30m",
 };
 
+// Per thread, since helper threads such as swaybar's icon theme loader log
+// too
+static _Thread_local time_t prefix_time = -1;
+static _Thread_local char prefix[26];
+
+/**
+ * Formats a complete line, including the time prefix and colours. Returns the
+ * length the line would have had, like snprintf.
+ */
+static int format_line(char *buf, size_t size,
+		sway_log_importance_t verbosity, time_t t, const char *message) {
+	if (t != prefix_time) {
+		struct tm result;
+		struct tm *tm_info = localtime_r(&t, &result);
+		strftime(prefix, sizeof(prefix), "%F %T - ", tm_info);
+		prefix_time = t;
+	}
+
+	unsigned c = (verbosity < SWAY_LOG_IMPORTANCE_LAST) ? verbosity :
+		SWAY_LOG_IMPORTANCE_LAST - 1;
+	bool color = colored && stderr_is_tty;
+	return snprintf(buf, size, "%s%s%s%s\n", prefix,
+			color ? verbosity_colors[c] : "", message, color ? "\x1B[0m" : "");
+}
+
 static void sway_log_stderr(sway_log_importance_t verbosity, const char *fmt,
 		va_list args) {
-	if (verbosity > log_importance) {
-		return;
+	char message[1024];
+	char *long_message = NULL;
+	va_list args_copy;
+	va_copy(args_copy, args);
+	int len = vsnprintf(message, sizeof(message), fmt, args_copy);
+	va_end(args_copy);
+	if (len >= (int)sizeof(message)) {
+		long_message = malloc(len + 1);
+		if (long_message) {
+			vsnprintf(long_message, len + 1, fmt, args);
+		}
 	}
-	// prefix the time to the log message
-	struct tm result;
-	time_t t = time(NULL);
-	struct tm *tm_info = localtime_r(&t, &result);
-	char buffer[26];
 
-	// generate time prefix
-	strftime(buffer, sizeof(buffer), "%F %T - ", tm_info);
-	fprintf(stderr, "%s", buffer);
+	const char *text = long_message ? long_message : message;
+	char line[1024 + 64];
+	char *long_line = NULL;
+	len = format_line(line, sizeof(line), verbosity, time(NULL), text);
+	if (len >= (int)sizeof(line)) {
+		long_line = malloc(len + 1);
+		if (long_line) {
+			format_line(long_line, len + 1, verbosity, prefix_time, text);
+		} else {
+			len = sizeof(line) - 1;
+		}
+	}
+	// A single write keeps lines from concurrent processes apart
+	fwrite(long_line ? long_line : line, 1, len, stderr);
+	free(long_line);
+	free(long_message);
+}
 
-	unsigned c = (verbosity < SWAY_LOG_IMPORTANCE_LAST) ? verbosity :
-		SWAY_LOG_IMPORTANCE_LAST - 1;
+/*
+ * The asynchronous sink is a bounded multi-producer queue of fixed size slots.
+ * Each slot carries a sequence number: it is free for the producer which
+ * reserved position n when it equals n, and holds a message for the writer
+ * when it equals n + 1.
+ */
+#define ASYNC_LOG_SLOTS 512 // Must be a power of two
+#define ASYNC_LOG_LENGTH 1024
+
+struct log_slot {
+	atomic_size_t sequence;
+	time_t time;
+	sway_log_importance_t verbosity;
+	char message[ASYNC_LOG_LENGTH];
+};
+
+static struct {
+	struct log_slot *slots;
+	atomic_size_t enqueue_pos;
+	size_t dequeue_pos; // Only touched by the writer
+	atomic_size_t dropped;
+	atomic_bool running;
+	atomic_bool enabled;
+	pthread_t thread;
+	pthread_mutex_t drain_lock;
+} async_log;
+
+static bool async_log_push(sway_log_importance_t verbosity, const char *fmt,
+		va_list args) {
+	size_t pos = atomic_load_explicit(&async_log.enqueue_pos,
+			memory_order_relaxed);
+	struct log_slot *slot;
+	while (true) {
+		slot = &async_log.slots[pos & (ASYNC_LOG_SLOTS - 1)];
+		size_t seq = atomic_load_explicit(&slot->sequence,
+				memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&async_log.enqueue_pos,
+						&pos, pos + 1, memory_order_relaxed,
+						memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// Full; never make the caller wait for the terminal
+			atomic_fetch_add_explicit(&async_log.dropped, 1,
+					memory_order_relaxed);
+			return false;
+		} else {
+			pos = atomic_load_explicit(&async_log.enqueue_pos,
+					memory_order_relaxed);
+		}
+	}
+
+	slot->time = time(NULL);
+	slot->verbosity = verbosity;
+	vsnprintf(slot->message, sizeof(slot->message), fmt, args);
+	atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+	return true;
+}
+
+static void write_all(const char *buf, size_t len) {
+	while (len > 0) {
+		ssize_t written = write(STDERR_FILENO, buf, len);
+		if (written < 0) {
+			return;
+		}
+		buf += written;
+		len -= written;
+	}
+}
+
+/**
+ * Writes out everything queued so far in as few writes as possible. Returns
+ * the number of messages written.
+ */
+static size_t async_log_drain(void) {
+	static char buf[64 * 1024];
+	size_t used = 0, count = 0;
+
+	pthread_mutex_lock(&async_log.drain_lock);
+	while (true) {
+		struct log_slot *slot =
+			&async_log.slots[async_log.dequeue_pos & (ASYNC_LOG_SLOTS - 1)];
+		size_t seq = atomic_load_explicit(&slot->sequence,
+				memory_order_acquire);
+		if (seq != async_log.dequeue_pos + 1) {
+			break;
+		}
+		if (used + ASYNC_LOG_LENGTH + 64 > sizeof(buf)) {
+			write_all(buf, used);
+			used = 0;
+		}
+		// Always fits: the message is bounded and we left room for the rest
+		used += format_line(buf + used, sizeof(buf) - used,
+				slot->verbosity, slot->time, slot->message);
+		atomic_store_explicit(&slot->sequence,
+				async_log.dequeue_pos + ASYNC_LOG_SLOTS, memory_order_release);
+		async_log.dequeue_pos++;
+		count++;
+	}
+
+	size_t dropped = atomic_exchange_explicit(&async_log.dropped, 0,
+			memory_order_relaxed);
+	if (dropped > 0) {
+		char message[64];
+		snprintf(message, sizeof(message),
+				"Dropped %zu log messages", dropped);
+		if (used + sizeof(message) + 64 > sizeof(buf)) {
+			write_all(buf, used);
+			used = 0;
+		}
+		used += format_line(buf + used, sizeof(buf) - used,
+				SWAY_ERROR, time(NULL), message);
+	}
+	write_all(buf, used);
+	pthread_mutex_unlock(&async_log.drain_lock);
+	return count;
+}
+
+static void *async_log_run(void *data) {
+	const struct timespec idle = { .tv_nsec = 5 * 1000 * 1000 };
+	while (atomic_load(&async_log.running)) {
+		if (async_log_drain() == 0) {
+			nanosleep(&idle, NULL);
+		}
+	}
+	async_log_drain();
+	return NULL;
+}
 
-	if (colored && isatty(STDERR_FILENO)) {
-		fprintf(stderr, "%s", verbosity_colors[c]);
+static void async_log_stop(void) {
+	if (!atomic_exchange(&async_log.enabled, false)) {
+		return;
 	}
+	atomic_store(&async_log.running, false);
+	pthread_join(async_log.thread, NULL);
+	// Producers which saw the sink enabled may still be filling slots
+	async_log_drain();
+}
 
-	vfprintf(stderr, fmt, args);
+bool sway_log_init_async(void) {
+	if (atomic_load(&async_log.enabled)) {
+		return true;
+	}
+	async_log.slots = calloc(ASYNC_LOG_SLOTS, sizeof(struct log_slot));
+	if (!async_log.slots) {
+		return false;
+	}
+	for (size_t i = 0; i < ASYNC_LOG_SLOTS; ++i) {
+		atomic_init(&async_log.slots[i].sequence, i);
+	}
+	atomic_init(&async_log.enqueue_pos, 0);
+	atomic_init(&async_log.dropped, 0);
+	async_log.dequeue_pos = 0;
+	pthread_mutex_init(&async_log.drain_lock, NULL);
 
-	if (colored && isatty(STDERR_FILENO)) {
-		fprintf(stderr, "\x1B[0m");
+	// Signals are handled by the main thread, which may rely on blocking them
+	// to receive them through a file descriptor
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	atomic_store(&async_log.running, true);
+	int ret = pthread_create(&async_log.thread, NULL, async_log_run, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (ret != 0) {
+		atomic_store(&async_log.running, false);
+		free(async_log.slots);
+		async_log.slots = NULL;
+		return false;
+	}
+	atomic_store(&async_log.enabled, true);
+	atexit(async_log_stop);
+	return true;
+}
+
+void sway_log_flush(void) {
+	if (atomic_load(&async_log.enabled)) {
+		async_log_drain();
 	}
-	fprintf(stderr, "\n");
 }
 
 void sway_log_init(sway_log_importance_t verbosity, terminate_callback_t callback) {
 	if (verbosity < SWAY_LOG_IMPORTANCE_LAST) {
-		log_importance = verbosity;
+		_sway_log_importance = verbosity;
 	}
 	if (callback) {
 		log_terminate = callback;
 	}
+	stderr_is_tty = isatty(STDERR_FILENO);
 }
 
 void _sway_vlog(sway_log_importance_t verbosity, const char *fmt, va_list args) {
-	sway_log_stderr(verbosity, fmt, args);
+	if (verbosity > _sway_log_importance) {
+		return;
+	}
+	if (atomic_load_explicit(&async_log.enabled, memory_order_relaxed)) {
+		async_log_push(verbosity, fmt, args);
+	} else {
+		sway_log_stderr(verbosity, fmt, args);
+	}
 }
 
 void _sway_log(sway_log_importance_t verbosity, const char *fmt, ...) {
 	va_list args;
 	va_start(args, fmt);
-	sway_log_stderr(verbosity, fmt, args);
+	_sway_vlog(verbosity, fmt, args);
 	va_end(args);
 }
 
@@ -79,10 +79,12 @@ list_t *split_string(const char *str, const char *delims) {
 	list_t *res = create_list();
 	char *copy = strdup(str);
 
-	char *token = strtok(copy, delims);
+	// Reentrant, as swaybar parses icon themes on a separate thread
+	char *saveptr;
+	char *token = strtok_r(copy, delims, &saveptr);
 	while (token) {
 		list_add(res, strdup(token));
-		token = strtok(NULL, delims);
+		token = strtok_r(NULL, delims, &saveptr);
 	}
 	free(copy);
 	return res;
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+
+# Converts a trace written by sway (swaymsg -t dump_trace, or SIGUSR2) to the
+# Chrome trace event format, which can be loaded in chrome://tracing or
+# https://ui.perfetto.dev.
+#
+# Usage: sway-trace-to-chrome.py sway-trace.1234.1571234567.bin > trace.json
+
+import json
+import struct
+import sys
+
+MAGIC = b'SWAYTRC1'
+HEADER = struct.Struct('=8sIIQQ')
+RECORD = struct.Struct('=QQIBBH')
+
+EVENTS = {
+    1: 'transaction',
+    2: 'transaction timeout',
+    3: 'configure',
+    4: 'ack',
+    5: 'frame',
+    6: 'input',
+    7: 'ipc',
+    8: 'command',
+}
+
+INPUTS = ['key', 'motion', 'button', 'axis', 'touch', 'tablet']
+
+IPC_TYPES = {
+    0: 'command', 1: 'get_workspaces', 2: 'subscribe', 3: 'get_outputs',
+    4: 'get_tree', 5: 'get_marks', 6: 'get_bar_config', 7: 'get_version',
+    8: 'get_binding_modes', 9: 'get_config', 10: 'send_tick', 11: 'sync',
+    100: 'get_inputs', 101: 'get_seats', 102: 'get_memory', 103: 'dump_trace',
+}
+
+INSTANT, BEGIN, END = 0, 1, 2
+
+# Everything but transactions happens synchronously on the compositor's main
+# thread, so those are shown as nested slices on a single track
+MAIN_THREAD = 1
+
+
+def read_trace(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    magic, record_size, name_count, count, overwritten = \
+        HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        sys.exit('{}: not a sway trace'.format(path))
+    if record_size != RECORD.size:
+        sys.exit('{}: unsupported record size {}'.format(path, record_size))
+
+    offset = HEADER.size
+    names = []
+    for _ in range(name_count):
+        (length,) = struct.unpack_from('=H', data, offset)
+        offset += 2
+        names.append(data[offset:offset + length].decode('utf-8', 'replace'))
+        offset += length
+
+    records = [RECORD.unpack_from(data, offset + i * RECORD.size)
+               for i in range(count)]
+    return names, records, overwritten
+
+
+def convert(names, records):
+    events = []
+    if not records:
+        return events
+    start = records[0][0]
+    for time, arg, id, event, phase, name in records:
+        kind = EVENTS.get(event, 'event {}'.format(event))
+        entry = {
+            'name': kind,
+            'cat': kind,
+            'ts': (time - start) / 1000.0,
+            'pid': 1,
+            'tid': MAIN_THREAD,
+            'args': {'id': id, 'arg': arg},
+        }
+        if event == 1:
+            # Transactions overlap each other and everything else
+            entry['ph'] = 'b' if phase == BEGIN else 'e'
+            entry['id'] = id
+            entry['args'] = {'instructions': arg}
+        elif phase == INSTANT:
+            entry['ph'] = 'i'
+            entry['s'] = 't'
+        else:
+            entry['ph'] = 'B' if phase == BEGIN else 'E'
+
+        if event == 2:
+            entry['args'] = {'transaction': id, 'waiting': arg}
+        elif event in (3, 4):
+            entry['args'] = {'container': id, 'serial': arg}
+        elif event == 5:
+            entry['name'] = 'frame (output {})'.format(id)
+            entry['args'] = {'output': id, 'rendered': bool(arg)}
+        elif event == 6:
+            entry['name'] = INPUTS[arg] if arg < len(INPUTS) else kind
+            entry['args'] = {}
+        elif event == 7:
+            entry['name'] = IPC_TYPES.get(arg, 'ipc 0x{:x}'.format(arg))
+            entry['args'] = {'client': id}
+        elif event == 8:
+            entry['name'] = names[name] if name < len(names) else kind
+            entry['args'] = {'status': arg} if phase == END else {}
+        events.append(entry)
+    return events
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('Usage: {} <trace>'.format(sys.argv[0]))
+    names, records, overwritten = read_trace(sys.argv[1])
+    if overwritten:
+        print('{} older records were overwritten'.format(overwritten),
+              file=sys.stderr)
+    json.dump({
+        'traceEvents': convert(names, records),
+        'displayTimeUnit': 'ms',
+    }, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
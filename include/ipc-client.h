@@ -7,6 +7,12 @@
 
 #include "ipc.h"
 
+/**
+ * Size of the header preceding every IPC message: the magic string, the
+ * payload size and the message type.
+ */
+#define IPC_HEADER_SIZE 14
+
 /**
  * IPC response including type of IPC response, size of payload and the json
  * encoded payload string.
@@ -25,6 +31,17 @@ char *get_socketpath(void);
  * Opens the sway socket.
  */
 int ipc_open_socket(const char *socket_path);
+/**
+ * Sends a message without waiting for the reply. Returns false if the message
+ * couldn't be written.
+ */
+bool ipc_send_message(int socketfd, uint32_t type, const char *payload,
+		uint32_t len);
+/**
+ * Parses an IPC header into the payload size and message type. Returns false
+ * if the header doesn't start with the IPC magic string.
+ */
+bool ipc_parse_header(const char *header, uint32_t *size, uint32_t *type);
 /**
  * Issues a single IPC command and returns the buffer. len will be updated with
  * the length of the buffer returned from sway.
@@ -28,27 +28,56 @@ typedef void (*terminate_callback_t)(int exit_code);
 // The `terminate` callback is called by `sway_abort`
 void sway_log_init(sway_log_importance_t verbosity, terminate_callback_t terminate);
 
+/**
+ * Hand formatted messages to a background thread which writes them to stderr,
+ * so logging never blocks the caller on the terminal or a slow pipe. Messages
+ * are truncated to a fixed length, and dropped (then counted in the log) if the
+ * writer falls behind. Returns false if the writer thread couldn't be started,
+ * in which case logging stays synchronous.
+ */
+bool sway_log_init_async(void);
+
+/**
+ * Write out any messages queued by the asynchronous sink.
+ */
+void sway_log_flush(void);
+
+// Only read through the macros below, so disabled messages cost a comparison
+extern sway_log_importance_t _sway_log_importance;
+
 void _sway_log(sway_log_importance_t verbosity, const char *format, ...) ATTRIB_PRINTF(2, 3);
 void _sway_vlog(sway_log_importance_t verbosity, const char *format, va_list args) ATTRIB_PRINTF(2, 0);
 void _sway_abort(const char *filename, ...) ATTRIB_PRINTF(1, 2);
 bool _sway_assert(bool condition, const char* format, ...) ATTRIB_PRINTF(2, 3);
 
-// TODO: get meson to precompute this, for better reproducibility/less overhead
 const char *_sway_strip_path(const char *filepath);
 
-#define sway_log(verb, fmt, ...) \
-	_sway_log(verb, "[%s:%d] " fmt, _sway_strip_path(__FILE__), __LINE__, ##__VA_ARGS__)
+// The build maps the source directory out of __FILE__ where the compiler
+// supports it, in which case this folds to a constant
+#define _SWAY_FILENAME \
+	((__FILE__[0] == '/' || __FILE__[0] == '.') ? \
+	 _sway_strip_path(__FILE__) : __FILE__)
+
+#define sway_log(verb, fmt, ...) do { \
+		if ((verb) <= _sway_log_importance) { \
+			_sway_log(verb, "[%s:%d] " fmt, _SWAY_FILENAME, __LINE__, \
+				##__VA_ARGS__); \
+		} \
+	} while (0)
 
-#define sway_vlog(verb, fmt, args) \
-	_sway_vlog(verb, "[%s:%d] " fmt, _sway_strip_path(__FILE__), __LINE__, args)
+#define sway_vlog(verb, fmt, args) do { \
+		if ((verb) <= _sway_log_importance) { \
+			_sway_vlog(verb, "[%s:%d] " fmt, _SWAY_FILENAME, __LINE__, args); \
+		} \
+	} while (0)
 
 #define sway_log_errno(verb, fmt, ...) \
 	sway_log(verb, fmt ": %s", ##__VA_ARGS__, strerror(errno))
 
 #define sway_abort(FMT, ...) \
-	_sway_abort("[%s:%d] " FMT, _sway_strip_path(__FILE__), __LINE__, ##__VA_ARGS__)
+	_sway_abort("[%s:%d] " FMT, _SWAY_FILENAME, __LINE__, ##__VA_ARGS__)
 
 #define sway_assert(COND, FMT, ...) \
-	_sway_assert(COND, "[%s:%d] %s:" FMT, _sway_strip_path(__FILE__), __LINE__, __PRETTY_FUNCTION__, ##__VA_ARGS__)
+	_sway_assert(COND, "[%s:%d] %s:" FMT, _SWAY_FILENAME, __LINE__, __PRETTY_FUNCTION__, ##__VA_ARGS__)
 
 #endif
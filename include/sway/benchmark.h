@@ -0,0 +1,63 @@
+#ifndef _SWAY_BENCHMARK_H
+#define _SWAY_BENCHMARK_H
+#include <stdbool.h>
+#include <time.h>
+
+enum sway_benchmark_metric {
+	BENCHMARK_FRAME,       // Time spent rendering an output frame
+	BENCHMARK_TRANSACTION, // Time from committing a transaction to applying it
+	BENCHMARK_COMMAND,     // Time spent running a scenario command
+	BENCHMARK_METRIC_COUNT,
+};
+
+/**
+ * Load a benchmark scenario and switch to the headless backend. Must be called
+ * before the backend is created.
+ */
+bool benchmark_init(const char *scenario_path);
+
+/**
+ * Start running the scenario once the server has started. Sway exits with a
+ * report on stdout when the scenario is done.
+ */
+void benchmark_start(void);
+
+/**
+ * Tear down the scenario. Must be called before the display is destroyed.
+ */
+void benchmark_finish(void);
+
+bool benchmark_is_running(void);
+
+/**
+ * Record the time elapsed since start for the metric.
+ */
+void benchmark_record(enum sway_benchmark_metric metric,
+		const struct timespec *start);
+
+/**
+ * A synthetic xdg-shell client which runs in the compositor process. This half
+ * only uses the client library; the compositor end of the socket is handled
+ * like any other client.
+ */
+struct benchmark_client;
+
+struct benchmark_client *benchmark_client_create(int fd, int width, int height,
+		const char *title);
+
+int benchmark_client_get_fd(struct benchmark_client *client);
+
+/**
+ * Dispatch the events waiting on the client's socket. Returns false if the
+ * connection has been lost.
+ */
+bool benchmark_client_dispatch(struct benchmark_client *client);
+
+/**
+ * Draw and commit a new buffer, if the surface has been configured.
+ */
+bool benchmark_client_commit(struct benchmark_client *client);
+
+void benchmark_client_destroy(struct benchmark_client *client);
+
+#endif
@@ -58,6 +58,28 @@ struct cmd_handler *find_handler(char *line, struct cmd_handler *cmd_handlers,
  */
 list_t *execute_command(char *command,  struct sway_seat *seat,
 		struct sway_container *con);
+/**
+ * A command list which has been split into its commands and arguments ahead
+ * of time, so it can be executed repeatedly without parsing it again.
+ */
+struct cmd_program;
+
+/**
+ * Compiles a command list into a program. Returns NULL if the command can't be
+ * compiled (eg. it uses criteria or contains an unknown command), in which
+ * case it should be run with execute_command instead.
+ */
+struct cmd_program *cmd_program_compile(const char *command);
+
+void cmd_program_destroy(struct cmd_program *program);
+
+/**
+ * Executes a compiled program on the `con` container, or the currently focused
+ * container if `con` is NULL.
+ */
+list_t *cmd_program_execute(struct cmd_program *program,
+		struct sway_seat *seat, struct sway_container *con);
+
 /**
  * Parse and handles a command during config file loading.
  *
@@ -145,6 +167,7 @@ sway_cmd cmd_kill;
 sway_cmd cmd_layout;
 sway_cmd cmd_log_colors;
 sway_cmd cmd_mark;
+sway_cmd cmd_memory_budget;
 sway_cmd cmd_mode;
 sway_cmd cmd_mouse_warping;
 sway_cmd cmd_move;
@@ -94,6 +94,10 @@ struct sway_mode {
 	list_t *mouse_bindings;
 	list_t *switch_bindings;
 	bool pango;
+
+	// mouse_bindings sorted by modifiers, release and buttons, for lookups.
+	// NULL until it is first needed and whenever mouse_bindings changes.
+	list_t *mouse_binding_index;
 };
 
 struct input_config_mapped_from_region {
@@ -483,6 +487,8 @@ struct sway_config {
 	bool tiling_drag;
 	int tiling_drag_threshold;
 
+	size_t memory_budget; // bytes, 0 for unlimited
+
 	bool smart_gaps;
 	int gaps_inner;
 	struct side_gaps gaps_outer;
@@ -626,6 +632,12 @@ struct output_config *new_output_config(const char *name);
 
 void merge_output_config(struct output_config *dst, struct output_config *src);
 
+/**
+ * Check whether the output config could be applied to the output, without
+ * changing any state.
+ */
+bool test_output_config(struct output_config *oc, struct sway_output *output);
+
 bool apply_output_config(struct output_config *oc, struct sway_output *output);
 
 struct output_config *store_output_config(struct output_config *oc);
@@ -648,6 +660,16 @@ void free_switch_binding(struct sway_switch_binding *binding);
 
 void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding);
 
+struct cmd_program;
+
+/**
+ * Like seat_execute_command, but runs a precompiled version of the binding's
+ * command if `program` is not NULL. This is for key repeats, so no binding
+ * event is sent: the press which started them already sent one.
+ */
+void seat_execute_command_program(struct sway_seat *seat,
+		struct sway_binding *binding, struct cmd_program *program);
+
 void load_swaybar(struct bar_config *bar);
 
 void load_swaybars(void);
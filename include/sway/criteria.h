@@ -53,6 +53,8 @@ void criteria_destroy(struct criteria *criteria);
  */
 struct criteria *criteria_parse(char *raw, char **error);
 
+bool criteria_matches_view(struct criteria *criteria, struct sway_view *view);
+
 /**
  * Compile a list of criterias matching the given view.
  *
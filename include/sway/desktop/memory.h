@@ -0,0 +1,72 @@
+#ifndef _SWAY_MEMORY_H
+#define _SWAY_MEMORY_H
+#include <stddef.h>
+#include <sys/types.h>
+#include "list.h"
+
+struct sway_container;
+struct sway_workspace;
+
+/**
+ * Memory accounting for buffers and textures retained by the compositor.
+ *
+ * Usage is collected on demand by walking the tree, so there is no
+ * bookkeeping on the hot paths. When a memory budget is configured, the
+ * compositor drops the title and marks textures of hidden containers once
+ * they exceed it, and regenerates them when the containers are shown again.
+ * The other categories are reported but can't be evicted: client buffers
+ * aren't ours, and saved buffers only live while a transaction is in flight.
+ */
+
+enum sway_memory_category {
+	MEMORY_VIEW_BUFFERS,
+	MEMORY_SAVED_BUFFERS,
+	MEMORY_TITLE_TEXTURES,
+	MEMORY_MARKS_TEXTURES,
+	MEMORY_LAYER_SURFACES,
+	MEMORY_CATEGORY_COUNT,
+};
+
+struct sway_memory_client {
+	pid_t pid;
+	size_t bytes[MEMORY_CATEGORY_COUNT];
+};
+
+struct sway_memory_usage {
+	size_t bytes[MEMORY_CATEGORY_COUNT];
+	list_t *clients; // struct sway_memory_client
+};
+
+struct sway_memory_evictions {
+	size_t title_textures; // containers whose textures were dropped
+};
+
+const char *memory_category_name(enum sway_memory_category category);
+
+/**
+ * Fill usage with the bytes currently retained per category and per client.
+ * The caller must release it with memory_usage_finish.
+ */
+void memory_usage_collect(struct sway_memory_usage *usage);
+
+void memory_usage_finish(struct sway_memory_usage *usage);
+
+size_t memory_usage_total(struct sway_memory_usage *usage);
+
+const struct sway_memory_evictions *memory_get_evictions(void);
+
+/**
+ * Check usage against the configured budget once the event loop is idle.
+ * Call this whenever something evictable has been allocated.
+ */
+void memory_budget_schedule_check(void);
+
+/**
+ * Regenerate the textures of a container which were evicted while it was
+ * hidden. Does nothing if the container is still hidden.
+ */
+void memory_restore_container(struct sway_container *con);
+
+void memory_restore_workspace(struct sway_workspace *ws);
+
+#endif
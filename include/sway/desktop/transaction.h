@@ -1,5 +1,6 @@
 #ifndef _SWAY_TRANSACTION_H
 #define _SWAY_TRANSACTION_H
+#include <stdbool.h>
 #include <stdint.h>
 
 /**
@@ -24,9 +25,16 @@ struct sway_view;
 
 /**
  * Find all dirty containers, create and commit a transaction containing them,
- * and unmark them as dirty.
+ * and unmark them as dirty. Returns the ID of the transaction, or 0 if nothing
+ * was dirty.
  */
-void transaction_commit_dirty(void);
+uint32_t transaction_commit_dirty(void);
+
+/**
+ * Whether the transaction with the given ID is still queued or waiting for
+ * clients.
+ */
+bool transaction_is_pending(uint32_t id);
 
 /**
  * Notify the transaction system that a view is ready for the new layout.
@@ -5,6 +5,7 @@
 #include <wlr/types/wlr_pointer_constraints_v1.h>
 #include <wlr/types/wlr_surface.h>
 #include "sway/input/seat.h"
+#include "list.h"
 
 #define SWAY_CURSOR_PRESSED_BUTTONS_CAP 32
 
@@ -13,6 +14,24 @@
 #define SWAY_SCROLL_LEFT KEY_MAX + 3
 #define SWAY_SCROLL_RIGHT KEY_MAX + 4
 
+/**
+ * A touch point which is currently down, along with the most recent motion
+ * which hasn't been sent to the client yet.
+ */
+struct sway_touch_point {
+	int32_t touch_id;
+	struct wlr_input_device *device;
+
+	// Hit test cache: the surface under the point and its layout origin
+	struct wlr_surface *surface;
+	double surface_lx, surface_ly;
+
+	bool motion_pending;
+	bool frame_pending; // motion was sent, but no frame after it yet
+	uint32_t motion_time_msec;
+	double lx, ly;
+};
+
 struct sway_cursor {
 	struct sway_seat *seat;
 	struct wlr_cursor *cursor;
@@ -39,12 +58,24 @@ struct sway_cursor {
 	struct wl_listener touch_down;
 	struct wl_listener touch_up;
 	struct wl_listener touch_motion;
+	list_t *touch_points; // struct sway_touch_point
 
 	struct wl_listener tool_axis;
 	struct wl_listener tool_tip;
 	struct wl_listener tool_button;
 	uint32_t tool_buttons;
 
+	// Tablet tool motion which hasn't been applied to the cursor yet
+	struct {
+		bool pending;
+		uint32_t time_msec;
+		struct wlr_input_device *device;
+		double lx, ly;
+	} tool_motion;
+
+	// Flushes pending touch and tablet motion once per event loop dispatch
+	struct wl_event_source *motion_flush_source;
+
 	struct wl_listener request_set_cursor;
 
 	struct wl_listener constraint_commit;
@@ -53,6 +84,11 @@ struct sway_cursor {
 	bool hidden;
 
 	size_t pressed_button_count;
+
+	// How often pointer motion skipped or performed a full rebase
+	struct {
+		uint64_t fast_path, full;
+	} rebase_stats;
 };
 
 struct sway_node;
@@ -72,6 +108,18 @@ struct sway_cursor *sway_cursor_create(struct sway_seat *seat);
 void cursor_rebase(struct sway_cursor *cursor);
 void cursor_rebase_all(void);
 
+/**
+ * Send any batched touch and tablet motion to clients immediately.
+ */
+void cursor_flush_motion(struct sway_cursor *cursor);
+
+/**
+ * Release the touch points of a device which is going away before they were
+ * lifted.
+ */
+void cursor_remove_touch_device(struct sway_cursor *cursor,
+		struct wlr_input_device *device);
+
 void cursor_handle_activity(struct sway_cursor *cursor);
 void cursor_unhide(struct sway_cursor *cursor);
 int cursor_get_timeout(struct sway_cursor *cursor);
@@ -83,6 +131,16 @@ void dispatch_cursor_button(struct sway_cursor *cursor,
 void dispatch_cursor_axis(struct sway_cursor *cursor,
 		struct wlr_event_pointer_axis *event);
 
+/**
+ * XCursor managers are shared by all seats and Xwayland, so each theme and
+ * size is only loaded once. The manager loads each scale the first time it's
+ * asked for, and is destroyed when the last user releases it.
+ */
+struct wlr_xcursor_manager *xcursor_manager_acquire(const char *theme,
+		unsigned size);
+
+void xcursor_manager_release(struct wlr_xcursor_manager *manager);
+
 void cursor_set_image(struct sway_cursor *cursor, const char *image,
 	struct wl_client *client);
 
@@ -63,6 +63,8 @@ struct sway_keyboard {
 
 	struct wl_event_source *key_repeat_source;
 	struct sway_binding *repeat_binding;
+	struct cmd_program *repeat_program; // NULL if it couldn't be compiled
+	uint32_t repeat_transaction; // ID of the last repeat's transaction
 };
 
 struct xkb_keymap *sway_keyboard_compile_keymap(struct input_config *ic,
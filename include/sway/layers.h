@@ -17,6 +17,12 @@ struct sway_layer_surface {
 
 	bool configured;
 	struct wlr_box geo;
+
+	// The state the surface had when its output's layers were last arranged
+	bool arranged;
+	bool arranged_mapped;
+	enum zwlr_layer_shell_v1_layer arranged_layer;
+	struct wlr_layer_surface_v1_state arranged_state;
 };
 
 struct sway_output;
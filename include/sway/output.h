@@ -36,6 +36,9 @@ struct sway_output {
 	bool enabled, configured;
 	list_t *workspaces;
 
+	// Changes made while an output configuration batch is open
+	bool batch_needs_arrange, batch_needs_textures;
+
 	struct sway_output_state current;
 
 	struct wl_listener destroy;
@@ -74,6 +77,10 @@ void output_damage_whole(struct sway_output *output);
 void output_damage_surface(struct sway_output *output, double ox, double oy,
 	struct wlr_surface *surface, bool whole);
 
+/**
+ * Damage the view's surfaces on the output. The caller is responsible for
+ * checking that the view is visible.
+ */
 void output_damage_from_view(struct sway_output *output,
 	struct sway_view *view);
 
@@ -154,6 +161,25 @@ void scale_box(struct wlr_box *box, float scale);
 
 enum wlr_direction opposite_direction(enum wlr_direction d);
 
+/**
+ * While an output configuration batch is open, mode, scale and transform
+ * changes and enabling or disabling outputs don't arrange the tree or commit
+ * transactions. Ending the batch arranges and commits once for everything
+ * which changed. Batches can be nested.
+ */
+void output_config_batch_begin(void);
+
+void output_config_batch_end(void);
+
+bool output_config_batch_is_open(void);
+
+/**
+ * Records that the tree needs to be arranged once the current output
+ * configuration batch ends. Returns false if no batch is open, in which case
+ * the caller should arrange immediately.
+ */
+bool output_config_batch_defer_arrange(void);
+
 void handle_output_manager_apply(struct wl_listener *listener, void *data);
 
 void handle_output_manager_test(struct wl_listener *listener, void *data);
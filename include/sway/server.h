@@ -73,6 +73,7 @@ struct sway_server {
 	struct wl_listener output_manager_test;
 
 	size_t txn_timeout_ms;
+	size_t trace_records;
 	list_t *transactions;
 	list_t *dirty_nodes;
 };
@@ -83,6 +84,9 @@ struct sway_debug {
 	bool noatomic;         // Ignore atomic layout updates
 	bool txn_timings;      // Log verbose messages about transactions
 	bool txn_wait;         // Always wait for the timeout before applying
+	bool xwayland_nowait;  // Don't wait for Xwayland acks on position changes
+	bool log_async;        // Write log messages from a background thread
+	bool notrace;          // Don't keep a trace of recent events
 
 	enum {
 		DAMAGE_DEFAULT,    // Default behaviour
@@ -0,0 +1,87 @@
+#ifndef _SWAY_TRACE_H
+#define _SWAY_TRACE_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A flight recorder: a fixed-size ring of compact binary records which is
+ * always on and overwrites its oldest records. It is written to a file on
+ * request over IPC or when sway receives SIGUSR2, and the file can be
+ * converted for trace viewers with contrib/sway-trace-to-chrome.py.
+ */
+
+enum sway_trace_event {
+	TRACE_TRANSACTION = 1,     // id: transaction, arg: instructions
+	TRACE_TRANSACTION_TIMEOUT, // id: transaction, arg: views not ready
+	TRACE_CONFIGURE,           // id: container, arg: serial
+	TRACE_ACK,                 // id: container, arg: serial
+	TRACE_FRAME,               // id: output, arg: whether anything was drawn
+	TRACE_INPUT,               // arg: enum sway_trace_input
+	TRACE_IPC,                 // id: client fd, arg: message type
+	TRACE_COMMAND,             // name: command
+};
+
+enum sway_trace_phase {
+	TRACE_INSTANT,
+	TRACE_BEGIN,
+	TRACE_END,
+};
+
+enum sway_trace_input {
+	TRACE_INPUT_KEY,
+	TRACE_INPUT_MOTION,
+	TRACE_INPUT_BUTTON,
+	TRACE_INPUT_AXIS,
+	TRACE_INPUT_TOUCH,
+	TRACE_INPUT_TABLET,
+};
+
+/**
+ * The dump is a header, the name table and then the records from oldest to
+ * newest, all in host byte order:
+ *
+ *   char magic[8] = "SWAYTRC1"
+ *   uint32_t record_size, name_count
+ *   uint64_t record_count, overwritten
+ *   name_count times: uint16_t length, char name[length]
+ *   record_count times: struct sway_trace_record
+ *
+ * Name 0 is the empty string.
+ */
+struct sway_trace_record {
+	uint64_t time; // CLOCK_MONOTONIC in nanoseconds
+	uint64_t arg;
+	uint32_t id;
+	uint8_t event;
+	uint8_t phase;
+	uint16_t name;
+};
+
+/**
+ * Allocate the ring and listen for SIGUSR2. Records are dropped until this is
+ * called.
+ */
+bool trace_init(size_t capacity);
+
+void trace_finish(void);
+
+void trace_record(enum sway_trace_event event, enum sway_trace_phase phase,
+		uint32_t id, uint64_t arg);
+
+/**
+ * Like trace_record, with a name. The name must be a static string: it is
+ * remembered by address.
+ */
+void trace_record_named(enum sway_trace_event event,
+		enum sway_trace_phase phase, const char *name, uint32_t id,
+		uint64_t arg);
+
+/**
+ * Write the ring to a new file in XDG_RUNTIME_DIR. Existing files are never
+ * overwritten. Returns the path written to, which the caller must free, or
+ * NULL on failure.
+ */
+char *trace_dump(size_t *record_count);
+
+#endif
@@ -151,6 +151,9 @@ struct sway_container {
 	struct wlr_texture *marks_unfocused;
 	struct wlr_texture *marks_urgent;
 
+	// Title and marks textures were dropped to stay within the memory budget
+	bool textures_evicted;
+
 	struct {
 		struct wl_signal destroy;
 	} events;
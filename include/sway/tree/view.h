@@ -111,6 +111,12 @@ struct sway_view {
 	} events;
 
 	struct wl_listener surface_new_subsurface;
+
+	// Every subsurface and popup of the view, and the box which the mapped
+	// ones cover, relative to the view's content. Kept up to date from the
+	// children's own events so that commits don't have to walk them.
+	struct wl_list children; // sway_view_child::view_link
+	struct wlr_box child_extents;
 };
 
 struct sway_xdg_shell_v6_view {
@@ -170,7 +176,8 @@ struct sway_xwayland_unmanaged {
 	struct wlr_xwayland_surface *wlr_xwayland_surface;
 	struct wl_list link;
 
-	int lx, ly;
+	// Layout coordinates and size of the surface while it is mapped
+	struct wlr_box box;
 
 	struct wl_listener request_configure;
 	struct wl_listener request_fullscreen;
@@ -200,6 +207,9 @@ struct sway_view_child {
 	struct wlr_surface *surface;
 	bool mapped;
 
+	struct wl_list view_link; // sway_view::children
+	struct wlr_box box; // relative to the view's content, empty if unmapped
+
 	struct wl_listener surface_commit;
 	struct wl_listener surface_new_subsurface;
 	struct wl_listener surface_map;
@@ -293,6 +303,9 @@ void view_close(struct sway_view *view);
 
 void view_close_popups(struct sway_view *view);
 
+/**
+ * Damage the view's surfaces on the outputs its container intersects.
+ */
 void view_damage_from(struct sway_view *view);
 
 /**
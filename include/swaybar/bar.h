@@ -3,6 +3,7 @@
 #include <wayland-client.h>
 #include "config.h"
 #include "input.h"
+#include "list.h"
 #include "pool-buffer.h"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 #include "xdg-output-unstable-v1-client-protocol.h"
@@ -15,32 +16,23 @@ struct swaybar_tray;
 struct swaybar_workspace;
 struct loop;
 
-struct swaybar {
-	char *id;
-	char *mode;
-	bool mode_pango_markup;
-
-	// only relevant when bar is in "hide" mode
-	bool visible_by_modifier;
-	bool visible_by_urgency;
-	bool visible_by_mode;
-	bool visible;
-
+/**
+ * The connections shared by all the bars served by this process: the Wayland
+ * display and its seats, the IPC sockets and the tray.
+ */
+struct swaybar_client {
 	struct wl_display *display;
 	struct wl_compositor *compositor;
 	struct zwlr_layer_shell_v1 *layer_shell;
 	struct zxdg_output_manager_v1 *xdg_output_manager;
 	struct wl_shm *shm;
 
-	struct swaybar_config *config;
-	struct status_line *status;
-
 	struct loop *eventloop;
 
 	int ipc_event_socketfd;
 	int ipc_socketfd;
 
-	struct wl_list outputs; // swaybar_output::link
+	struct wl_list bars; // swaybar::link
 	struct wl_list seats; // swaybar_seat::link
 
 #if HAVE_TRAY
@@ -50,6 +42,26 @@ struct swaybar {
 	bool running;
 };
 
+struct swaybar {
+	struct wl_list link; // swaybar_client::bars
+	struct swaybar_client *client;
+
+	char *id;
+	char *mode;
+	bool mode_pango_markup;
+
+	// only relevant when bar is in "hide" mode
+	bool visible_by_modifier;
+	bool visible_by_urgency;
+	bool visible_by_mode;
+	bool visible;
+
+	struct swaybar_config *config;
+	struct status_line *status;
+
+	struct wl_list outputs; // swaybar_output::link
+};
+
 struct swaybar_output {
 	struct wl_list link; // swaybar::outputs
 	struct swaybar *bar;
@@ -88,11 +100,17 @@ struct swaybar_workspace {
 	bool urgent;
 };
 
-bool bar_setup(struct swaybar *bar, const char *socket_path);
-void bar_run(struct swaybar *bar);
-void bar_teardown(struct swaybar *bar);
+/**
+ * Sets up a bar for each of the IDs, all sharing the client's connections.
+ * Bars whose configuration can't be found are skipped.
+ */
+bool bar_setup(struct swaybar_client *client, const char *socket_path,
+		list_t *bar_ids);
+void bar_run(struct swaybar_client *client);
+void bar_teardown(struct swaybar_client *client);
 
 void set_bar_dirty(struct swaybar *bar);
+void set_all_bars_dirty(struct swaybar_client *client);
 
 /*
  * Determines whether the bar should be visible and changes it to be so.
@@ -9,7 +9,7 @@
 #define SWAY_SCROLL_LEFT KEY_MAX + 3
 #define SWAY_SCROLL_RIGHT KEY_MAX + 4
 
-struct swaybar;
+struct swaybar_client;
 struct swaybar_output;
 
 struct swaybar_pointer {
@@ -51,7 +51,7 @@ struct swaybar_hotspot {
 };
 
 struct swaybar_seat {
-	struct swaybar *bar;
+	struct swaybar_client *client;
 	uint32_t wl_name;
 	struct wl_seat *wl_seat;
 	struct swaybar_pointer pointer;
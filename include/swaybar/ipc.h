@@ -3,9 +3,17 @@
 #include <stdbool.h>
 #include "swaybar/bar.h"
 
+/**
+ * Fetch the bar's configuration and the outputs it should appear on.
+ */
 bool ipc_initialize(struct swaybar *bar);
-bool handle_ipc_readable(struct swaybar *bar);
-bool ipc_get_workspaces(struct swaybar *bar);
+
+/**
+ * Subscribe to the events needed by all of the client's bars.
+ */
+void ipc_subscribe(struct swaybar_client *client);
+void handle_ipc_readable(struct swaybar_client *client);
+void ipc_get_workspaces(struct swaybar_client *client);
 void ipc_send_workspace_command(struct swaybar *bar, const char *ws);
 void ipc_execute_binding(struct swaybar *bar, struct swaybar_binding *bind);
 
@@ -1,6 +1,8 @@
 #ifndef _SWAYBAR_TRAY_ICON_H
 #define _SWAYBAR_TRAY_ICON_H
 
+#include <pthread.h>
+#include <stdbool.h>
 #include "list.h"
 
 enum subdir_type {
@@ -28,7 +30,31 @@ struct icon_theme {
 	list_t *subdirs; // struct icon_theme_subdir *
 };
 
-void init_themes(list_t **themes, list_t **basedirs);
+/*
+ * Loads the icon themes on a separate thread, as parsing every index.theme
+ * can take a while. Parsed themes are cached on disk and reused as long as
+ * the modification time and size of their index.theme are unchanged.
+ */
+struct icon_theme_loader {
+	pthread_t thread;
+	int fd; // becomes readable once the themes are loaded
+	int done_fd;
+
+	list_t *themes; // struct icon_theme *
+	list_t *basedirs; // char *
+	int parsed; // number of index.theme files which weren't cached
+};
+
+/*
+ * Starts loading the themes. Returns false if the thread can't be started.
+ */
+bool init_themes(struct icon_theme_loader *loader);
+
+/*
+ * Waits for the loader to finish and hands over what it loaded.
+ */
+void finish_loading_themes(struct icon_theme_loader *loader,
+		list_t **themes, list_t **basedirs);
 void finish_themes(list_t *themes, list_t *basedirs);
 
 /*
@@ -7,6 +7,7 @@
 #include "swaybar/tray/tray.h"
 #include "list.h"
 
+struct loop_timer;
 struct swaybar_output;
 
 struct swaybar_pixmap {
@@ -14,12 +15,21 @@ struct swaybar_pixmap {
 	unsigned char pixels[];
 };
 
+/**
+ * An icon loaded for one theme and range of sizes. The tray is shared by all
+ * bars, which may each want a different theme and size.
+ */
+struct swaybar_sni_icon {
+	char *theme; // NULL for the default theme
+	int min_size;
+	int max_size;
+	cairo_surface_t *surface; // NULL if no icon was found
+};
+
 struct swaybar_sni {
 	// icon properties
 	struct swaybar_tray *tray;
-	cairo_surface_t *icon;
-	int min_size;
-	int max_size;
+	list_t *icons; // struct swaybar_sni_icon *
 
 	// dbus properties
 	char *watcher_id;
@@ -36,6 +46,10 @@ struct swaybar_sni {
 	char *menu;
 	char *icon_theme_path; // non-standard KDE property
 
+	sd_bus_slot *get_all_slot; // pending GetAll call
+	bool refetch_pending;
+	struct loop_timer *refetch_timer;
+
 	sd_bus_slot *new_icon_slot;
 	sd_bus_slot *new_attention_icon_slot;
 	sd_bus_slot *new_status_slot;
@@ -43,6 +57,7 @@ struct swaybar_sni {
 
 struct swaybar_sni *create_sni(char *id, struct swaybar_tray *tray);
 void destroy_sni(struct swaybar_sni *sni);
+void sni_invalidate_icons(struct swaybar_sni *sni);
 uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 		struct swaybar_sni *sni);
 
@@ -10,14 +10,15 @@
 #include <cairo.h>
 #include <stdint.h>
 #include "swaybar/tray/host.h"
+#include "swaybar/tray/icon.h"
 #include "list.h"
 
-struct swaybar;
+struct swaybar_client;
 struct swaybar_output;
 struct swaybar_watcher;
 
 struct swaybar_tray {
-	struct swaybar *bar;
+	struct swaybar_client *client;
 
 	int fd;
 	sd_bus *bus;
@@ -28,11 +29,13 @@ struct swaybar_tray {
 	struct swaybar_watcher *watcher_xdg;
 	struct swaybar_watcher *watcher_kde;
 
+	struct icon_theme_loader theme_loader;
+	// NULL until the theme loader is done
 	list_t *basedirs; // char *
 	list_t *themes; // struct swaybar_theme *
 };
 
-struct swaybar_tray *create_tray(struct swaybar *bar);
+struct swaybar_tray *create_tray(struct swaybar_client *client);
 void destroy_tray(struct swaybar_tray *tray);
 void tray_in(int fd, short mask, void *data);
 uint32_t render_tray(cairo_t *cairo, struct swaybar_output *output, double *x);
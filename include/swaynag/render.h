@@ -4,4 +4,9 @@
 
 void render_frame(struct swaynag *swaynag);
 
+/**
+ * Drops the laid out details, which must be done whenever their text changes.
+ */
+void render_details_invalidate(struct swaynag *swaynag);
+
 #endif
@@ -3,13 +3,16 @@
 #include <stdint.h>
 #include <strings.h>
 #include "list.h"
+#include "loop.h"
 #include "pool-buffer.h"
 #include "swaynag/types.h"
 #include "xdg-output-unstable-v1-client-protocol.h"
 
 #define SWAYNAG_MAX_HEIGHT 500
+#define SWAYNAG_DETAILS_MAX_SIZE (1024 * 1024)
 
 struct swaynag;
+struct swaynag_details_layout;
 
 enum swaynag_action_type {
 	SWAYNAG_ACTION_DISMISS,
@@ -50,6 +53,15 @@ struct swaynag_button {
 struct swaynag_details {
 	bool visible;
 	char *message;
+	// Length of the complete lines read so far, without trailing newlines
+	size_t message_len;
+
+	// The message is read from stdin while swaynag is shown
+	bool reading;
+	size_t read_len, read_size;
+	size_t max_size;
+	bool truncated;
+	struct loop_timer *render_timer;
 
 	int x;
 	int y;
@@ -62,6 +74,8 @@ struct swaynag_details {
 	struct swaynag_button *button_details;
 	struct swaynag_button button_up;
 	struct swaynag_button button_down;
+
+	struct swaynag_details_layout *layout; // Cached by render_detailed
 };
 
 struct swaynag {
@@ -90,6 +104,8 @@ struct swaynag {
 	char *message;
 	list_t *buttons;
 	struct swaynag_details details;
+
+	struct loop *eventloop;
 };
 
 void swaynag_setup(struct swaynag *swaynag);
@@ -0,0 +1,497 @@
+#define _POSIX_C_SOURCE 200809L
+#include <json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-server.h>
+#include "sway/benchmark.h"
+#include "sway/commands.h"
+#include "sway/desktop/transaction.h"
+#include "sway/server.h"
+#include "list.h"
+#include "log.h"
+#include "stringop.h"
+#include "util.h"
+
+void sway_terminate(int exit_code);
+
+enum scenario_step_type {
+	STEP_COMMAND,
+	STEP_WAIT,
+	STEP_CLIENT,
+};
+
+struct scenario_step {
+	enum scenario_step_type type;
+	char *command; // STEP_COMMAND
+	int wait_ms; // STEP_WAIT
+	int width, height, rate; // STEP_CLIENT
+};
+
+struct metric_samples {
+	double *samples; // milliseconds
+	size_t length, capacity;
+};
+
+struct hosted_client {
+	struct benchmark_client *client;
+	struct wl_event_source *fd_source;
+	struct wl_event_source *commit_timer;
+	int interval_ms;
+};
+
+static struct {
+	bool running;
+	char *scenario_path;
+	list_t *steps; // struct scenario_step
+	int current_step;
+	struct wl_event_source *step_timer;
+
+	list_t *clients; // struct hosted_client
+	size_t client_commits;
+
+	struct metric_samples metrics[BENCHMARK_METRIC_COUNT];
+	struct timespec start_time;
+	struct rusage start_usage;
+} benchmark;
+
+static const char *metric_names[BENCHMARK_METRIC_COUNT] = {
+	[BENCHMARK_FRAME] = "frame",
+	[BENCHMARK_TRANSACTION] = "transaction",
+	[BENCHMARK_COMMAND] = "command",
+};
+
+static double timespec_to_msec(const struct timespec *ts) {
+	return ts->tv_sec * 1000.0 + ts->tv_nsec / 1000000.0;
+}
+
+static double timeval_to_msec(const struct timeval *tv) {
+	return tv->tv_sec * 1000.0 + tv->tv_usec / 1000.0;
+}
+
+static void free_step(struct scenario_step *step) {
+	free(step->command);
+	free(step);
+}
+
+static struct scenario_step *add_step(enum scenario_step_type type) {
+	struct scenario_step *step = calloc(1, sizeof(struct scenario_step));
+	if (!step) {
+		sway_log(SWAY_ERROR, "Unable to allocate scenario step");
+		return NULL;
+	}
+	step->type = type;
+	list_add(benchmark.steps, step);
+	return step;
+}
+
+static bool word_is(const char *line, size_t len, const char *word) {
+	return strlen(word) == len && strncmp(line, word, len) == 0;
+}
+
+/**
+ * Scenario lines are sway commands, or one of:
+ *
+ *   wait <ms>
+ *   client <width>x<height> <commits per second>
+ *   repeat <count> <command>
+ */
+static bool parse_scenario_line(char *line, int line_number) {
+	size_t len = strcspn(line, " \t");
+	char *rest = line + len + strspn(line + len, " \t");
+
+	if (word_is(line, len, "wait")) {
+		char *end;
+		int ms = strtol(rest, &end, 10);
+		if (end == rest || *end != '\0' || ms < 0) {
+			sway_log(SWAY_ERROR, "Scenario line %d: expected 'wait <ms>'",
+					line_number);
+			return false;
+		}
+		struct scenario_step *step = add_step(STEP_WAIT);
+		if (step) {
+			step->wait_ms = ms;
+		}
+		return true;
+	}
+
+	if (word_is(line, len, "client")) {
+		int width, height, rate;
+		if (sscanf(rest, "%dx%d %d", &width, &height, &rate) != 3 ||
+				width <= 0 || height <= 0 || rate < 0) {
+			sway_log(SWAY_ERROR, "Scenario line %d: expected "
+					"'client <width>x<height> <commits per second>'",
+					line_number);
+			return false;
+		}
+		struct scenario_step *step = add_step(STEP_CLIENT);
+		if (step) {
+			step->width = width;
+			step->height = height;
+			step->rate = rate;
+		}
+		return true;
+	}
+
+	if (word_is(line, len, "repeat")) {
+		char *end;
+		int count = strtol(rest, &end, 10);
+		char *command = end + strspn(end, " \t");
+		if (end == rest || command == end || count < 0) {
+			sway_log(SWAY_ERROR, "Scenario line %d: expected "
+					"'repeat <count> <command>'", line_number);
+			return false;
+		}
+		for (int i = 0; i < count; ++i) {
+			struct scenario_step *step = add_step(STEP_COMMAND);
+			if (step) {
+				step->command = strdup(command);
+			}
+		}
+		return true;
+	}
+
+	struct scenario_step *step = add_step(STEP_COMMAND);
+	if (step) {
+		step->command = strdup(line);
+	}
+	return true;
+}
+
+bool benchmark_init(const char *scenario_path) {
+	FILE *f = fopen(scenario_path, "r");
+	if (!f) {
+		sway_log_errno(SWAY_ERROR, "Unable to open benchmark scenario %s",
+				scenario_path);
+		return false;
+	}
+
+	benchmark.scenario_path = strdup(scenario_path);
+	benchmark.steps = create_list();
+	benchmark.clients = create_list();
+
+	bool success = true;
+	char *line = NULL;
+	size_t line_size = 0;
+	int line_number = 0;
+	while (getline(&line, &line_size, f) != -1) {
+		++line_number;
+		strip_whitespace(line);
+		if (!*line || *line == '#') {
+			continue;
+		}
+		if (!parse_scenario_line(line, line_number)) {
+			success = false;
+			break;
+		}
+	}
+	free(line);
+	fclose(f);
+
+	if (!success) {
+		benchmark_finish();
+		return false;
+	}
+
+	// Run without touching real hardware
+	setenv("WLR_BACKENDS", "headless", true);
+	if (!getenv("WLR_HEADLESS_OUTPUTS")) {
+		setenv("WLR_HEADLESS_OUTPUTS", "1", true);
+	}
+	return true;
+}
+
+bool benchmark_is_running(void) {
+	return benchmark.running;
+}
+
+void benchmark_record(enum sway_benchmark_metric metric,
+		const struct timespec *start) {
+	if (!benchmark.running) {
+		return;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	struct metric_samples *samples = &benchmark.metrics[metric];
+	if (samples->length == samples->capacity) {
+		size_t capacity = samples->capacity ? samples->capacity * 2 : 256;
+		double *new_samples =
+			realloc(samples->samples, capacity * sizeof(double));
+		if (!new_samples) {
+			sway_log(SWAY_ERROR, "Unable to allocate benchmark samples");
+			return;
+		}
+		samples->samples = new_samples;
+		samples->capacity = capacity;
+	}
+	samples->samples[samples->length++] =
+		timespec_to_msec(&now) - timespec_to_msec(start);
+}
+
+static void destroy_hosted_client(struct hosted_client *hosted) {
+	if (hosted->fd_source) {
+		wl_event_source_remove(hosted->fd_source);
+	}
+	if (hosted->commit_timer) {
+		wl_event_source_remove(hosted->commit_timer);
+	}
+	benchmark_client_destroy(hosted->client);
+	free(hosted);
+}
+
+static int handle_client_readable(int fd, uint32_t mask, void *data) {
+	struct hosted_client *hosted = data;
+	if ((mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) ||
+			!benchmark_client_dispatch(hosted->client)) {
+		sway_log(SWAY_ERROR, "Benchmark client disconnected");
+		int index = list_find(benchmark.clients, hosted);
+		if (index != -1) {
+			list_del(benchmark.clients, index);
+		}
+		destroy_hosted_client(hosted);
+	}
+	return 0;
+}
+
+static int handle_client_commit(void *data) {
+	struct hosted_client *hosted = data;
+	if (benchmark_client_commit(hosted->client)) {
+		benchmark.client_commits++;
+	}
+	wl_event_source_timer_update(hosted->commit_timer, hosted->interval_ms);
+	return 0;
+}
+
+static void spawn_client(struct scenario_step *step) {
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+		sway_log_errno(SWAY_ERROR, "socketpair failed");
+		return;
+	}
+	if (!set_cloexec(sockets[0], true) || !set_cloexec(sockets[1], true)) {
+		close(sockets[0]);
+		close(sockets[1]);
+		return;
+	}
+	if (!wl_client_create(server.wl_display, sockets[0])) {
+		sway_log_errno(SWAY_ERROR, "wl_client_create failed");
+		close(sockets[0]);
+		close(sockets[1]);
+		return;
+	}
+
+	struct hosted_client *hosted = calloc(1, sizeof(struct hosted_client));
+	if (!hosted) {
+		sway_log(SWAY_ERROR, "Unable to allocate benchmark client");
+		close(sockets[1]);
+		return;
+	}
+	char title[32];
+	snprintf(title, sizeof(title), "benchmark %d", benchmark.clients->length);
+	hosted->client = benchmark_client_create(sockets[1],
+			step->width, step->height, title);
+	if (!hosted->client) {
+		close(sockets[1]);
+		free(hosted);
+		return;
+	}
+	hosted->fd_source = wl_event_loop_add_fd(server.wl_event_loop,
+			benchmark_client_get_fd(hosted->client), WL_EVENT_READABLE,
+			handle_client_readable, hosted);
+	if (step->rate > 0) {
+		hosted->interval_ms = 1000 / step->rate;
+		if (hosted->interval_ms < 1) {
+			hosted->interval_ms = 1;
+		}
+		hosted->commit_timer = wl_event_loop_add_timer(server.wl_event_loop,
+				handle_client_commit, hosted);
+		wl_event_source_timer_update(hosted->commit_timer,
+				hosted->interval_ms);
+	}
+	list_add(benchmark.clients, hosted);
+}
+
+static void run_command(struct scenario_step *step) {
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	list_t *res_list = execute_command(step->command, NULL, NULL);
+	transaction_commit_dirty();
+
+	benchmark_record(BENCHMARK_COMMAND, &start);
+
+	for (int i = 0; i < res_list->length; ++i) {
+		struct cmd_results *results = res_list->items[i];
+		if (results->status != CMD_SUCCESS) {
+			sway_log(SWAY_ERROR, "Benchmark command '%s' failed: %s",
+					step->command, results->error);
+		}
+		free_cmd_results(results);
+	}
+	list_free(res_list);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static json_object *describe_metric(struct metric_samples *samples) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "count",
+			json_object_new_int64(samples->length));
+	if (!samples->length) {
+		return object;
+	}
+
+	double *sorted = malloc(samples->length * sizeof(double));
+	if (!sorted) {
+		return object;
+	}
+	memcpy(sorted, samples->samples, samples->length * sizeof(double));
+	qsort(sorted, samples->length, sizeof(double), compare_doubles);
+
+	double total = 0;
+	for (size_t i = 0; i < samples->length; ++i) {
+		total += sorted[i];
+	}
+	json_object_object_add(object, "total_ms", json_object_new_double(total));
+	json_object_object_add(object, "min_ms",
+			json_object_new_double(sorted[0]));
+	json_object_object_add(object, "mean_ms",
+			json_object_new_double(total / samples->length));
+	json_object_object_add(object, "p50_ms",
+			json_object_new_double(sorted[samples->length / 2]));
+	json_object_object_add(object, "p99_ms",
+			json_object_new_double(sorted[samples->length * 99 / 100]));
+	json_object_object_add(object, "max_ms",
+			json_object_new_double(sorted[samples->length - 1]));
+	free(sorted);
+	return object;
+}
+
+static void print_report(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	json_object *report = json_object_new_object();
+	json_object_object_add(report, "scenario",
+			json_object_new_string(benchmark.scenario_path));
+	json_object_object_add(report, "duration_ms", json_object_new_double(
+			timespec_to_msec(&now) - timespec_to_msec(&benchmark.start_time)));
+
+	json_object *metrics = json_object_new_object();
+	for (int i = 0; i < BENCHMARK_METRIC_COUNT; ++i) {
+		json_object_object_add(metrics, metric_names[i],
+				describe_metric(&benchmark.metrics[i]));
+	}
+	json_object_object_add(report, "metrics", metrics);
+
+	json_object *clients = json_object_new_object();
+	json_object_object_add(clients, "count",
+			json_object_new_int(benchmark.clients->length));
+	json_object_object_add(clients, "commits",
+			json_object_new_int64(benchmark.client_commits));
+	json_object_object_add(report, "clients", clients);
+
+	json_object *cpu = json_object_new_object();
+	json_object_object_add(cpu, "user_ms", json_object_new_double(
+			timeval_to_msec(&usage.ru_utime) -
+			timeval_to_msec(&benchmark.start_usage.ru_utime)));
+	json_object_object_add(cpu, "system_ms", json_object_new_double(
+			timeval_to_msec(&usage.ru_stime) -
+			timeval_to_msec(&benchmark.start_usage.ru_stime)));
+	json_object_object_add(report, "cpu", cpu);
+
+	json_object *memory = json_object_new_object();
+	json_object_object_add(memory, "max_rss_kb",
+			json_object_new_int64(usage.ru_maxrss));
+	json_object_object_add(memory, "minor_faults", json_object_new_int64(
+			usage.ru_minflt - benchmark.start_usage.ru_minflt));
+	json_object_object_add(report, "memory", memory);
+
+	printf("%s\n", json_object_to_json_string_ext(report,
+			JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_SPACED));
+	fflush(stdout);
+	json_object_put(report);
+}
+
+static int handle_step_timer(void *data) {
+	while (benchmark.current_step < benchmark.steps->length) {
+		struct scenario_step *step =
+			benchmark.steps->items[benchmark.current_step++];
+		switch (step->type) {
+		case STEP_WAIT:
+			wl_event_source_timer_update(benchmark.step_timer,
+					step->wait_ms > 0 ? step->wait_ms : 1);
+			return 0;
+		case STEP_CLIENT:
+			spawn_client(step);
+			break;
+		case STEP_COMMAND:
+			run_command(step);
+			// Let clients respond before the next command
+			wl_event_source_timer_update(benchmark.step_timer, 1);
+			return 0;
+		}
+	}
+
+	// Let the last transactions settle so their latency is counted
+	if (server.transactions->length > 0) {
+		wl_event_source_timer_update(benchmark.step_timer, 1);
+		return 0;
+	}
+
+	print_report();
+	benchmark.running = false;
+	sway_terminate(EXIT_SUCCESS);
+	return 0;
+}
+
+void benchmark_start(void) {
+	sway_log(SWAY_INFO, "Running benchmark scenario %s (%d steps)",
+			benchmark.scenario_path, benchmark.steps->length);
+	benchmark.running = true;
+	clock_gettime(CLOCK_MONOTONIC, &benchmark.start_time);
+	getrusage(RUSAGE_SELF, &benchmark.start_usage);
+
+	benchmark.step_timer = wl_event_loop_add_timer(server.wl_event_loop,
+			handle_step_timer, NULL);
+	wl_event_source_timer_update(benchmark.step_timer, 1);
+}
+
+void benchmark_finish(void) {
+	benchmark.running = false;
+	if (benchmark.step_timer) {
+		wl_event_source_remove(benchmark.step_timer);
+		benchmark.step_timer = NULL;
+	}
+	if (benchmark.clients) {
+		for (int i = 0; i < benchmark.clients->length; ++i) {
+			destroy_hosted_client(benchmark.clients->items[i]);
+		}
+		list_free(benchmark.clients);
+		benchmark.clients = NULL;
+	}
+	if (benchmark.steps) {
+		for (int i = 0; i < benchmark.steps->length; ++i) {
+			free_step(benchmark.steps->items[i]);
+		}
+		list_free(benchmark.steps);
+		benchmark.steps = NULL;
+	}
+	for (int i = 0; i < BENCHMARK_METRIC_COUNT; ++i) {
+		free(benchmark.metrics[i].samples);
+		benchmark.metrics[i].samples = NULL;
+		benchmark.metrics[i].length = benchmark.metrics[i].capacity = 0;
+	}
+	free(benchmark.scenario_path);
+	benchmark.scenario_path = NULL;
+}
@@ -0,0 +1,206 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-client.h>
+#include "log.h"
+#include "pool-buffer.h"
+#include "sway/benchmark.h"
+#include "xdg-shell-client-protocol.h"
+
+struct benchmark_client {
+	struct wl_display *display;
+	struct wl_registry *registry;
+	struct wl_compositor *compositor;
+	struct wl_shm *shm;
+	struct xdg_wm_base *wm_base;
+
+	struct wl_surface *surface;
+	struct xdg_surface *xdg_surface;
+	struct xdg_toplevel *xdg_toplevel;
+	struct pool_buffer buffers[2];
+
+	char *title;
+	uint32_t width, height;
+	uint32_t frame;
+	bool configured;
+};
+
+static void draw(struct benchmark_client *client) {
+	struct pool_buffer *buffer = get_next_buffer(client->shm, client->buffers,
+			client->width, client->height);
+	if (!buffer) {
+		// Both buffers are still held by the compositor
+		return;
+	}
+
+	// Cycle the colour so every commit changes the whole buffer
+	double shade = (client->frame++ % 64) / 64.0;
+	cairo_set_source_rgba(buffer->cairo, shade, 0.25, 1.0 - shade, 1.0);
+	cairo_paint(buffer->cairo);
+
+	wl_surface_attach(client->surface, buffer->buffer, 0, 0);
+	wl_surface_damage(client->surface, 0, 0, client->width, client->height);
+	wl_surface_commit(client->surface);
+}
+
+static void xdg_surface_handle_configure(void *data,
+		struct xdg_surface *xdg_surface, uint32_t serial) {
+	struct benchmark_client *client = data;
+	xdg_surface_ack_configure(xdg_surface, serial);
+	client->configured = true;
+	draw(client);
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+	.configure = xdg_surface_handle_configure,
+};
+
+static void xdg_toplevel_handle_configure(void *data,
+		struct xdg_toplevel *xdg_toplevel, int32_t width, int32_t height,
+		struct wl_array *states) {
+	struct benchmark_client *client = data;
+	if (width > 0 && height > 0) {
+		client->width = width;
+		client->height = height;
+	}
+}
+
+static void xdg_toplevel_handle_close(void *data,
+		struct xdg_toplevel *xdg_toplevel) {
+	// The scenario decides when clients go away
+}
+
+static const struct xdg_toplevel_listener xdg_toplevel_listener = {
+	.configure = xdg_toplevel_handle_configure,
+	.close = xdg_toplevel_handle_close,
+};
+
+static void wm_base_handle_ping(void *data, struct xdg_wm_base *wm_base,
+		uint32_t serial) {
+	xdg_wm_base_pong(wm_base, serial);
+}
+
+static const struct xdg_wm_base_listener wm_base_listener = {
+	.ping = wm_base_handle_ping,
+};
+
+static void create_toplevel(struct benchmark_client *client) {
+	if (client->surface || !client->compositor || !client->shm ||
+			!client->wm_base) {
+		return;
+	}
+	client->surface = wl_compositor_create_surface(client->compositor);
+	client->xdg_surface =
+		xdg_wm_base_get_xdg_surface(client->wm_base, client->surface);
+	xdg_surface_add_listener(client->xdg_surface, &xdg_surface_listener,
+			client);
+	client->xdg_toplevel = xdg_surface_get_toplevel(client->xdg_surface);
+	xdg_toplevel_add_listener(client->xdg_toplevel, &xdg_toplevel_listener,
+			client);
+	xdg_toplevel_set_app_id(client->xdg_toplevel, "sway-benchmark");
+	xdg_toplevel_set_title(client->xdg_toplevel, client->title);
+	wl_surface_commit(client->surface);
+}
+
+static void handle_global(void *data, struct wl_registry *registry,
+		uint32_t name, const char *interface, uint32_t version) {
+	struct benchmark_client *client = data;
+	if (strcmp(interface, wl_compositor_interface.name) == 0) {
+		client->compositor =
+			wl_registry_bind(registry, name, &wl_compositor_interface, 3);
+	} else if (strcmp(interface, wl_shm_interface.name) == 0) {
+		client->shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+	} else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+		client->wm_base =
+			wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+		xdg_wm_base_add_listener(client->wm_base, &wm_base_listener, client);
+	}
+	create_toplevel(client);
+}
+
+static void handle_global_remove(void *data, struct wl_registry *registry,
+		uint32_t name) {
+	// Who cares
+}
+
+static const struct wl_registry_listener registry_listener = {
+	.global = handle_global,
+	.global_remove = handle_global_remove,
+};
+
+struct benchmark_client *benchmark_client_create(int fd, int width, int height,
+		const char *title) {
+	struct benchmark_client *client =
+		calloc(1, sizeof(struct benchmark_client));
+	if (!client) {
+		sway_log(SWAY_ERROR, "Unable to allocate benchmark client");
+		return NULL;
+	}
+	client->display = wl_display_connect_to_fd(fd);
+	if (!client->display) {
+		sway_log(SWAY_ERROR, "Unable to connect benchmark client");
+		free(client);
+		return NULL;
+	}
+	client->width = width;
+	client->height = height;
+	client->title = strdup(title);
+
+	// Nothing here may block: the compositor runs on the same thread, so the
+	// globals arrive through benchmark_client_dispatch
+	client->registry = wl_display_get_registry(client->display);
+	wl_registry_add_listener(client->registry, &registry_listener, client);
+	wl_display_flush(client->display);
+	return client;
+}
+
+int benchmark_client_get_fd(struct benchmark_client *client) {
+	return wl_display_get_fd(client->display);
+}
+
+bool benchmark_client_dispatch(struct benchmark_client *client) {
+	if (wl_display_dispatch(client->display) == -1) {
+		return false;
+	}
+	wl_display_flush(client->display);
+	return true;
+}
+
+bool benchmark_client_commit(struct benchmark_client *client) {
+	if (!client->configured) {
+		return false;
+	}
+	draw(client);
+	wl_display_flush(client->display);
+	return true;
+}
+
+void benchmark_client_destroy(struct benchmark_client *client) {
+	if (!client) {
+		return;
+	}
+	destroy_buffer(&client->buffers[0]);
+	destroy_buffer(&client->buffers[1]);
+	if (client->xdg_toplevel) {
+		xdg_toplevel_destroy(client->xdg_toplevel);
+	}
+	if (client->xdg_surface) {
+		xdg_surface_destroy(client->xdg_surface);
+	}
+	if (client->surface) {
+		wl_surface_destroy(client->surface);
+	}
+	if (client->wm_base) {
+		xdg_wm_base_destroy(client->wm_base);
+	}
+	if (client->shm) {
+		wl_shm_destroy(client->shm);
+	}
+	if (client->compositor) {
+		wl_compositor_destroy(client->compositor);
+	}
+	wl_registry_destroy(client->registry);
+	wl_display_disconnect(client->display);
+	free(client->title);
+	free(client);
+}
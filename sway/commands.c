@@ -10,6 +10,7 @@
 #include "sway/config.h"
 #include "sway/criteria.h"
 #include "sway/security.h"
+#include "sway/trace.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
 #include "sway/tree/view.h"
@@ -75,6 +76,7 @@ static struct cmd_handler handlers[] = {
 	{ "hide_edge_borders", cmd_hide_edge_borders },
 	{ "include", cmd_include },
 	{ "input", cmd_input },
+	{ "memory_budget", cmd_memory_budget },
 	{ "mode", cmd_mode },
 	{ "mouse_warping", cmd_mouse_warping },
 	{ "new_float", cmd_new_float },
@@ -196,6 +198,44 @@ static void set_config_node(struct sway_node *node) {
 	}
 }
 
+/**
+ * Splits a single command into its arguments and looks up its handler.
+ * Returns NULL if there is no handler for the command. The arguments are
+ * allocated either way and must be freed by the caller.
+ */
+static struct cmd_handler *parse_command(char *cmd, int *argc, char ***argv) {
+	//TODO better handling of argv
+	*argv = split_args(cmd, argc);
+	if (strcmp((*argv)[0], "exec") != 0 &&
+			strcmp((*argv)[0], "exec_always") != 0 &&
+			strcmp((*argv)[0], "mode") != 0) {
+		for (int i = 1; i < *argc; ++i) {
+			if (*(*argv)[i] == '\"' || *(*argv)[i] == '\'') {
+				strip_quotes((*argv)[i]);
+			}
+		}
+	}
+	struct cmd_handler *handler = find_core_handler((*argv)[0]);
+	if (!handler) {
+		return NULL;
+	}
+
+	// Var replacement, for all but first argument of set
+	for (int i = handler->handle == cmd_set ? 2 : 1; i < *argc; ++i) {
+		(*argv)[i] = do_var_replacement((*argv)[i]);
+	}
+	return handler;
+}
+
+static struct cmd_results *run_handler(struct cmd_handler *handler,
+		int argc, char **argv) {
+	trace_record_named(TRACE_COMMAND, TRACE_BEGIN, handler->command, 0, 0);
+	struct cmd_results *res = handler->handle(argc, argv);
+	trace_record_named(TRACE_COMMAND, TRACE_END, handler->command, 0,
+			res->status);
+	return res;
+}
+
 list_t *execute_command(char *_exec, struct sway_seat *seat,
 		struct sway_container *con) {
 	list_t *res_list = create_list();
@@ -248,19 +288,9 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 			continue;
 		}
 		sway_log(SWAY_INFO, "Handling command '%s'", cmd);
-		//TODO better handling of argv
 		int argc;
-		char **argv = split_args(cmd, &argc);
-		if (strcmp(argv[0], "exec") != 0 &&
-				strcmp(argv[0], "exec_always") != 0 &&
-				strcmp(argv[0], "mode") != 0) {
-			for (int i = 1; i < argc; ++i) {
-				if (*argv[i] == '\"' || *argv[i] == '\'') {
-					strip_quotes(argv[i]);
-				}
-			}
-		}
-		struct cmd_handler *handler = find_core_handler(argv[0]);
+		char **argv;
+		struct cmd_handler *handler = parse_command(cmd, &argc, &argv);
 		if (!handler) {
 			list_add(res_list, cmd_results_new(CMD_INVALID,
 					"Unknown/invalid command '%s'", argv[0]));
@@ -268,17 +298,12 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 			goto cleanup;
 		}
 
-		// Var replacement, for all but first argument of set
-		for (int i = handler->handle == cmd_set ? 2 : 1; i < argc; ++i) {
-			argv[i] = do_var_replacement(argv[i]);
-		}
-
 		if (!config->handler_context.using_criteria) {
 			// The container or workspace which this command will run on.
 			struct sway_node *node = con ? &con->node :
 					seat_get_focus_inactive(seat, &root->node);
 			set_config_node(node);
-			struct cmd_results *res = handler->handle(argc-1, argv+1);
+			struct cmd_results *res = run_handler(handler, argc-1, argv+1);
 			list_add(res_list, res);
 			if (res->status == CMD_INVALID) {
 				free_argv(argc, argv);
@@ -288,7 +313,7 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 			for (int i = 0; i < views->length; ++i) {
 				struct sway_view *view = views->items[i];
 				set_config_node(&view->container->node);
-				struct cmd_results *res = handler->handle(argc-1, argv+1);
+				struct cmd_results *res = run_handler(handler, argc-1, argv+1);
 				list_add(res_list, res);
 				if (res->status == CMD_INVALID) {
 					free_argv(argc, argv);
@@ -304,6 +329,113 @@ cleanup:
 	return res_list;
 }
 
+struct cmd_program_step {
+	struct cmd_handler *handler;
+	int argc;
+	char **argv;
+};
+
+struct cmd_program {
+	list_t *steps; // struct cmd_program_step
+};
+
+struct cmd_program *cmd_program_compile(const char *command) {
+	// Criteria have to be matched against the tree each time they run
+	if (strchr(command, '[')) {
+		return NULL;
+	}
+
+	struct cmd_program *program = calloc(1, sizeof(struct cmd_program));
+	if (!program) {
+		return NULL;
+	}
+	program->steps = create_list();
+
+	char *exec = strdup(command);
+	if (!exec) {
+		cmd_program_destroy(program);
+		return NULL;
+	}
+	char *head = exec;
+	char matched_delim = ';';
+	do {
+		char *cmd = argsep(&head, ";,", &matched_delim);
+		for (; isspace(*cmd); ++cmd) {}
+		if (strcmp(cmd, "") == 0) {
+			continue;
+		}
+		struct cmd_program_step *step =
+			calloc(1, sizeof(struct cmd_program_step));
+		if (!step) {
+			goto error;
+		}
+		list_add(program->steps, step);
+		step->handler = parse_command(cmd, &step->argc, &step->argv);
+		if (!step->handler) {
+			goto error;
+		}
+	} while (head);
+	free(exec);
+	return program;
+
+error:
+	free(exec);
+	cmd_program_destroy(program);
+	return NULL;
+}
+
+void cmd_program_destroy(struct cmd_program *program) {
+	if (!program) {
+		return;
+	}
+	for (int i = 0; i < program->steps->length; ++i) {
+		struct cmd_program_step *step = program->steps->items[i];
+		if (step->argv) {
+			free_argv(step->argc, step->argv);
+		}
+		free(step);
+	}
+	list_free(program->steps);
+	free(program);
+}
+
+list_t *cmd_program_execute(struct cmd_program *program,
+		struct sway_seat *seat, struct sway_container *con) {
+	list_t *res_list = create_list();
+	config->handler_context.seat = seat;
+	config->handler_context.using_criteria = false;
+
+	for (int i = 0; i < program->steps->length; ++i) {
+		struct cmd_program_step *step = program->steps->items[i];
+		// Handlers are allowed to modify their arguments in place
+		char **argv = calloc(step->argc + 1, sizeof(char *));
+		if (!argv) {
+			break;
+		}
+		bool copied = true;
+		for (int j = 0; j < step->argc && copied; ++j) {
+			argv[j] = strdup(step->argv[j]);
+			copied = argv[j] != NULL;
+		}
+		if (!copied) {
+			free_argv(step->argc, argv);
+			break;
+		}
+
+		struct sway_node *node = con ? &con->node :
+				seat_get_focus_inactive(seat, &root->node);
+		set_config_node(node);
+		struct cmd_results *res = run_handler(step->handler, step->argc - 1,
+				argv + 1);
+		list_add(res_list, res);
+		free_argv(step->argc, argv);
+		if (res->status == CMD_INVALID) {
+			break;
+		}
+	}
+	return res_list;
+}
+
 // this is like execute_command above, except:
 // 1) it ignores empty commands (empty lines)
 // 2) it does variable substitution
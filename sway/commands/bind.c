@@ -441,6 +441,8 @@ static struct cmd_results *cmd_bindsym_or_bindcode(int argc, char **argv,
 		mode_bindings = config->current_mode->keysym_bindings;
 	} else {
 		mode_bindings = config->current_mode->mouse_bindings;
+		list_free(config->current_mode->mouse_binding_index);
+		config->current_mode->mouse_binding_index = NULL;
 	}
 
 	if (unbind) {
@@ -557,10 +559,9 @@ struct cmd_results *cmd_unbindswitch(int argc, char **argv) {
 	return cmd_bind_or_unbind_switch(argc, argv, true);
 }
 
-/**
- * Execute the command associated to a binding
- */
-void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding) {
+static void execute_binding(struct sway_seat *seat,
+		struct sway_binding *binding, struct cmd_program *program,
+		bool send_event) {
 	if (!config->active) {
 		sway_log(SWAY_DEBUG, "deferring command for binding: %s",
 				binding->command);
@@ -588,7 +589,8 @@ void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding)
 		}
 	}
 
-	list_t *res_list = execute_command(binding->command, seat, con);
+	list_t *res_list = program ? cmd_program_execute(program, seat, con) :
+		execute_command(binding->command, seat, con);
 	bool success = true;
 	for (int i = 0; i < res_list->length; ++i) {
 		struct cmd_results *results = res_list->items[i];
@@ -600,11 +602,23 @@ void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding)
 		free_cmd_results(results);
 	}
 	list_free(res_list);
-	if (success) {
+	if (success && send_event) {
 		ipc_event_binding(binding);
 	}
 }
 
+/**
+ * Execute the command associated to a binding
+ */
+void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding) {
+	execute_binding(seat, binding, NULL, true);
+}
+
+void seat_execute_command_program(struct sway_seat *seat,
+		struct sway_binding *binding, struct cmd_program *program) {
+	execute_binding(seat, binding, program, false);
+}
+
 /**
  * The last found keycode associated with the keysym
  * and the total count of matches.
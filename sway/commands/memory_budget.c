@@ -0,0 +1,58 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+#include "sway/desktop/memory.h"
+
+struct cmd_results *cmd_memory_budget(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "memory_budget", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+
+	if (strcasecmp(argv[0], "none") == 0) {
+		config->memory_budget = 0;
+		return cmd_results_new(CMD_SUCCESS, NULL);
+	}
+
+	char *end;
+	errno = 0;
+	unsigned long long value = strtoull(argv[0], &end, 10);
+	if (end == argv[0] || argv[0][0] == '-' || errno == ERANGE) {
+		return cmd_results_new(CMD_INVALID,
+				"Expected 'memory_budget none|<size>[K|M|G]'");
+	}
+	unsigned long long unit = 1;
+	switch (*end) {
+	case 'G':
+	case 'g':
+		unit = 1024ULL * 1024 * 1024;
+		++end;
+		break;
+	case 'M':
+	case 'm':
+		unit = 1024ULL * 1024;
+		++end;
+		break;
+	case 'K':
+	case 'k':
+		unit = 1024ULL;
+		++end;
+		break;
+	}
+	if (*end != '\0') {
+		return cmd_results_new(CMD_INVALID,
+				"Expected 'memory_budget none|<size>[K|M|G]'");
+	}
+	if (value > SIZE_MAX / unit) {
+		return cmd_results_new(CMD_INVALID,
+				"Memory budget %s is too large", argv[0]);
+	}
+
+	config->memory_budget = value * unit;
+	memory_budget_schedule_check();
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
@@ -75,6 +75,7 @@ static void free_mode(struct sway_mode *mode) {
 		}
 		list_free(mode->mouse_bindings);
 	}
+	list_free(mode->mouse_binding_index);
 	if (mode->switch_bindings) {
 		for (int i = 0; i < mode->switch_bindings->length; i++) {
 			free_switch_binding(mode->switch_bindings->items[i]);
@@ -223,7 +224,7 @@ static void config_defaults(struct sway_config *config) {
 
 	if (!(config->cmd_queue = create_list())) goto cleanup;
 
-	if (!(config->current_mode = malloc(sizeof(struct sway_mode))))
+	if (!(config->current_mode = calloc(1, sizeof(struct sway_mode))))
 		goto cleanup;
 	if (!(config->current_mode->name = malloc(sizeof("default")))) goto cleanup;
 	strcpy(config->current_mode->name, "default");
@@ -275,6 +276,8 @@ static void config_defaults(struct sway_config *config) {
 	config->tiling_drag = true;
 	config->tiling_drag_threshold = 9;
 
+	config->memory_budget = 0;
+
 	config->smart_gaps = false;
 	config->gaps_inner = 0;
 	config->gaps_outer.top = 0;
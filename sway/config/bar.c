@@ -187,28 +187,54 @@ static void handle_swaybar_client_destroy(struct wl_listener *listener,
 	bar->client = NULL;
 }
 
-static void invoke_swaybar(struct bar_config *bar) {
+/**
+ * Spawn one swaybar process for all the given bars, which must share the same
+ * swaybar_command. They share its Wayland client too.
+ */
+static void invoke_swaybar(list_t *bars) {
+	struct bar_config *first = bars->items[0];
+	// swaybar_command -b id... NULL
+	char **cmd = calloc(2 * bars->length + 2, sizeof(char *));
+	if (!cmd) {
+		sway_log(SWAY_ERROR, "Unable to allocate swaybar arguments");
+		return;
+	}
+	cmd[0] = first->swaybar_command ? first->swaybar_command : "swaybar";
+	for (int i = 0; i < bars->length; ++i) {
+		struct bar_config *bar = bars->items[i];
+		cmd[2 * i + 1] = "-b";
+		cmd[2 * i + 2] = bar->id;
+	}
+
 	int sockets[2];
 	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
 		sway_log_errno(SWAY_ERROR, "socketpair failed");
+		free(cmd);
 		return;
 	}
 	if (!set_cloexec(sockets[0], true) || !set_cloexec(sockets[1], true)) {
+		free(cmd);
 		return;
 	}
 
-	bar->client = wl_client_create(server.wl_display, sockets[0]);
-	if (bar->client == NULL) {
+	struct wl_client *client = wl_client_create(server.wl_display, sockets[0]);
+	if (client == NULL) {
 		sway_log_errno(SWAY_ERROR, "wl_client_create failed");
+		free(cmd);
 		return;
 	}
 
-	bar->client_destroy.notify = handle_swaybar_client_destroy;
-	wl_client_add_destroy_listener(bar->client, &bar->client_destroy);
+	for (int i = 0; i < bars->length; ++i) {
+		struct bar_config *bar = bars->items[i];
+		bar->client = client;
+		bar->client_destroy.notify = handle_swaybar_client_destroy;
+		wl_client_add_destroy_listener(client, &bar->client_destroy);
+	}
 
 	pid_t pid = fork();
 	if (pid < 0) {
 		sway_log(SWAY_ERROR, "Failed to create fork for swaybar");
+		free(cmd);
 		return;
 	} else if (pid == 0) {
 		// Remove the SIGUSR1 handler that wlroots adds for xwayland
@@ -231,14 +257,12 @@ static void invoke_swaybar(struct bar_config *bar) {
 			setenv("WAYLAND_SOCKET", wayland_socket_str, true);
 
 			// run custom swaybar
-			char *const cmd[] = {
-					bar->swaybar_command ? bar->swaybar_command : "swaybar",
-					"-b", bar->id, NULL};
 			execvp(cmd[0], cmd);
 			_exit(EXIT_FAILURE);
 		}
 		_exit(EXIT_SUCCESS);
 	}
+	free(cmd);
 
 	if (close(sockets[1]) != 0) {
 		sway_log_errno(SWAY_ERROR, "close failed");
@@ -250,21 +274,53 @@ static void invoke_swaybar(struct bar_config *bar) {
 		return;
 	}
 
-	sway_log(SWAY_DEBUG, "Spawned swaybar %s", bar->id);
+	sway_log(SWAY_DEBUG, "Spawned swaybar for %d bar(s) starting with %s",
+			bars->length, first->id);
 	return;
 }
 
 void load_swaybar(struct bar_config *bar) {
+	// Every bar served by the same process goes down with it, so respawn them
+	// all together
+	list_t *bars = create_list();
 	if (bar->client != NULL) {
+		for (int i = 0; i < config->bars->length; ++i) {
+			struct bar_config *other = config->bars->items[i];
+			if (other->client == bar->client) {
+				list_add(bars, other);
+			}
+		}
 		wl_client_destroy(bar->client);
 	}
+	if (list_find(bars, bar) == -1) {
+		list_add(bars, bar);
+	}
 	sway_log(SWAY_DEBUG, "Invoking swaybar for bar id '%s'", bar->id);
-	invoke_swaybar(bar);
+	invoke_swaybar(bars);
+	list_free(bars);
 }
 
 void load_swaybars(void) {
+	// Bars using the default swaybar_command are all served by one process,
+	// so that they share its connections, caches and tray
+	list_t *shared = create_list();
 	for (int i = 0; i < config->bars->length; ++i) {
 		struct bar_config *bar = config->bars->items[i];
-		load_swaybar(bar);
+		if (bar->client != NULL) {
+			wl_client_destroy(bar->client);
+		}
+		if (bar->swaybar_command) {
+			list_t *bars = create_list();
+			list_add(bars, bar);
+			sway_log(SWAY_DEBUG, "Invoking swaybar for bar id '%s'", bar->id);
+			invoke_swaybar(bars);
+			list_free(bars);
+		} else {
+			list_add(shared, bar);
+		}
+	}
+	if (shared->length > 0) {
+		invoke_swaybar(shared);
 	}
+	list_free(shared);
 }
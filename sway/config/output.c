@@ -1,5 +1,6 @@
 #define _POSIX_C_SOURCE 200809L
 #include <assert.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <string.h>
 #include <sys/socket.h>
@@ -227,6 +228,33 @@ static bool set_mode(struct wlr_output *output, int width, int height,
 	return wlr_output_set_mode(output, best);
 }
 
+bool test_output_config(struct output_config *oc,
+		struct sway_output *output) {
+	if (output == root->noop_output) {
+		return false;
+	}
+	if (!oc || !oc->enabled) {
+		return true;
+	}
+	if (oc->width == 0 || oc->height == 0 ||
+			(oc->width > 0) != (oc->height > 0)) {
+		sway_log(SWAY_DEBUG, "Invalid mode %dx%d for output %s",
+			oc->width, oc->height, output->wlr_output->name);
+		return false;
+	}
+	if (oc->scale == 0 || (oc->scale < 0 && oc->scale != -1)) {
+		sway_log(SWAY_DEBUG, "Invalid scale %f for output %s",
+			oc->scale, output->wlr_output->name);
+		return false;
+	}
+	if (oc->transform > WL_OUTPUT_TRANSFORM_FLIPPED_270) {
+		sway_log(SWAY_DEBUG, "Invalid transform %d for output %s",
+			oc->transform, output->wlr_output->name);
+		return false;
+	}
+	return true;
+}
+
 bool apply_output_config(struct output_config *oc, struct sway_output *output) {
 	if (output == root->noop_output) {
 		return false;
@@ -435,6 +463,7 @@ void apply_output_config_to_outputs(struct output_config *oc) {
 	bool wildcard = strcmp(oc->name, "*") == 0;
 	char id[128];
 	struct sway_output *sway_output;
+	output_config_batch_begin();
 	wl_list_for_each(sway_output, &root->all_outputs, link) {
 		char *name = sway_output->wlr_output->name;
 		output_get_identifier(id, sizeof(id), sway_output);
@@ -456,6 +485,7 @@ void apply_output_config_to_outputs(struct output_config *oc) {
 			}
 		}
 	}
+	output_config_batch_end();
 }
 
 void reset_outputs(void) {
@@ -516,6 +546,11 @@ static bool _spawn_swaybg(char **command) {
 		sway_log_errno(SWAY_ERROR, "fork failed");
 		return false;
 	} else if (pid == 0) {
+		// Unblock the signals the event loop reads with a signalfd, eg. SIGUSR2
+		sigset_t set;
+		sigemptyset(&set);
+		sigprocmask(SIG_SETMASK, &set, NULL);
+
 		pid = fork();
 		if (pid < 0) {
 			sway_log_errno(SWAY_ERROR, "fork failed");
@@ -97,7 +97,7 @@ static void find_urgent_iterator(struct sway_container *con, void *data) {
 	list_add(urgent_views, con->view);
 }
 
-static bool criteria_matches_view(struct criteria *criteria,
+bool criteria_matches_view(struct criteria *criteria,
 		struct sway_view *view) {
 	if (criteria->autofail) {
 		return false;
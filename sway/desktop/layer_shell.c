@@ -262,6 +262,28 @@ static void handle_output_destroy(struct wl_listener *listener, void *data) {
 	wlr_layer_surface_v1_close(sway_layer->layer_surface);
 }
 
+/**
+ * Returns true if the layer surface committed state which affects how the
+ * output's layers are arranged, as opposed to just a new buffer.
+ */
+static bool layer_needs_arrange(struct sway_layer_surface *sway_layer) {
+	struct wlr_layer_surface_v1 *layer_surface = sway_layer->layer_surface;
+	struct wlr_layer_surface_v1_state *state = &layer_surface->current;
+	struct wlr_layer_surface_v1_state *arranged = &sway_layer->arranged_state;
+	return !sway_layer->arranged ||
+		sway_layer->arranged_mapped != layer_surface->mapped ||
+		sway_layer->arranged_layer != layer_surface->layer ||
+		arranged->anchor != state->anchor ||
+		arranged->exclusive_zone != state->exclusive_zone ||
+		arranged->margin.top != state->margin.top ||
+		arranged->margin.right != state->margin.right ||
+		arranged->margin.bottom != state->margin.bottom ||
+		arranged->margin.left != state->margin.left ||
+		arranged->keyboard_interactive != state->keyboard_interactive ||
+		arranged->desired_width != state->desired_width ||
+		arranged->desired_height != state->desired_height;
+}
+
 static void handle_surface_commit(struct wl_listener *listener, void *data) {
 	struct sway_layer_surface *layer =
 		wl_container_of(listener, layer, surface_commit);
@@ -272,8 +294,18 @@ static void handle_surface_commit(struct wl_listener *listener, void *data) {
 	}
 
 	struct sway_output *output = wlr_output->data;
+	if (!layer_needs_arrange(layer)) {
+		output_damage_surface(output, layer->geo.x, layer->geo.y,
+			layer_surface->surface, false);
+		return;
+	}
+
 	struct wlr_box old_geo = layer->geo;
 	arrange_layers(output);
+	layer->arranged = true;
+	layer->arranged_mapped = layer_surface->mapped;
+	layer->arranged_layer = layer_surface->layer;
+	layer->arranged_state = layer_surface->current;
 	if (memcmp(&old_geo, &layer->geo, sizeof(struct wlr_box)) != 0) {
 		output_damage_surface(output, old_geo.x, old_geo.y,
 			layer_surface->surface, true);
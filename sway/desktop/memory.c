@@ -0,0 +1,284 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-server.h>
+#include <wlr/render/wlr_texture.h>
+#include <wlr/types/wlr_buffer.h>
+#include <wlr/types/wlr_layer_shell_v1.h>
+#include <wlr/types/wlr_surface.h>
+#include "sway/config.h"
+#include "sway/desktop/memory.h"
+#include "sway/layers.h"
+#include "sway/output.h"
+#include "sway/server.h"
+#include "sway/tree/container.h"
+#include "sway/tree/root.h"
+#include "sway/tree/view.h"
+#include "sway/tree/workspace.h"
+#include "list.h"
+#include "log.h"
+
+// Everything we account for is 32bpp
+#define BYTES_PER_PIXEL 4
+
+static struct sway_memory_evictions evictions;
+static struct wl_event_source *budget_check_source;
+
+const char *memory_category_name(enum sway_memory_category category) {
+	switch (category) {
+	case MEMORY_VIEW_BUFFERS:
+		return "view_buffers";
+	case MEMORY_SAVED_BUFFERS:
+		return "saved_buffers";
+	case MEMORY_TITLE_TEXTURES:
+		return "title_textures";
+	case MEMORY_MARKS_TEXTURES:
+		return "marks_textures";
+	case MEMORY_LAYER_SURFACES:
+		return "layer_surfaces";
+	case MEMORY_CATEGORY_COUNT:
+		break;
+	}
+	return NULL;
+}
+
+static size_t texture_bytes(struct wlr_texture *texture) {
+	if (!texture) {
+		return 0;
+	}
+	int width, height;
+	wlr_texture_get_size(texture, &width, &height);
+	return (size_t)width * height * BYTES_PER_PIXEL;
+}
+
+static size_t surface_bytes(struct wlr_surface *surface) {
+	if (!surface || !wlr_surface_has_buffer(surface)) {
+		return 0;
+	}
+	return (size_t)surface->current.buffer_width *
+		surface->current.buffer_height * BYTES_PER_PIXEL;
+}
+
+static size_t container_title_bytes(struct sway_container *con) {
+	return texture_bytes(con->title_focused) +
+		texture_bytes(con->title_focused_inactive) +
+		texture_bytes(con->title_unfocused) +
+		texture_bytes(con->title_urgent);
+}
+
+static size_t container_marks_bytes(struct sway_container *con) {
+	return texture_bytes(con->marks_focused) +
+		texture_bytes(con->marks_focused_inactive) +
+		texture_bytes(con->marks_unfocused) +
+		texture_bytes(con->marks_urgent);
+}
+
+static size_t view_saved_bytes(struct sway_view *view) {
+	// The saved buffer is shared with the surface until the client commits
+	// a new one, in which case it is only counted once
+	if (!view->saved_buffer || !view->saved_buffer->texture ||
+			(view->surface && view->saved_buffer == view->surface->buffer)) {
+		return 0;
+	}
+	return texture_bytes(view->saved_buffer->texture);
+}
+
+static struct sway_memory_client *get_client(struct sway_memory_usage *usage,
+		struct wlr_surface *surface) {
+	if (!surface || !surface->resource) {
+		return NULL;
+	}
+	pid_t pid;
+	wl_client_get_credentials(wl_resource_get_client(surface->resource),
+			&pid, NULL, NULL);
+	for (int i = 0; i < usage->clients->length; ++i) {
+		struct sway_memory_client *client = usage->clients->items[i];
+		if (client->pid == pid) {
+			return client;
+		}
+	}
+	struct sway_memory_client *client =
+		calloc(1, sizeof(struct sway_memory_client));
+	if (!client) {
+		sway_log(SWAY_ERROR, "Unable to allocate memory client");
+		return NULL;
+	}
+	client->pid = pid;
+	list_add(usage->clients, client);
+	return client;
+}
+
+static void account(struct sway_memory_usage *usage,
+		struct sway_memory_client *client,
+		enum sway_memory_category category, size_t bytes) {
+	usage->bytes[category] += bytes;
+	if (client) {
+		client->bytes[category] += bytes;
+	}
+}
+
+static void collect_container(struct sway_container *con, void *data) {
+	struct sway_memory_usage *usage = data;
+	struct sway_memory_client *client = NULL;
+	if (con->view) {
+		client = get_client(usage, con->view->surface);
+		account(usage, client, MEMORY_VIEW_BUFFERS,
+				surface_bytes(con->view->surface));
+		account(usage, client, MEMORY_SAVED_BUFFERS,
+				view_saved_bytes(con->view));
+	}
+	account(usage, client, MEMORY_TITLE_TEXTURES, container_title_bytes(con));
+	account(usage, client, MEMORY_MARKS_TEXTURES, container_marks_bytes(con));
+}
+
+void memory_usage_collect(struct sway_memory_usage *usage) {
+	memset(usage, 0, sizeof(struct sway_memory_usage));
+	usage->clients = create_list();
+
+	root_for_each_container(collect_container, usage);
+
+	struct sway_output *output;
+	wl_list_for_each(output, &root->all_outputs, link) {
+		for (size_t i = 0; i < sizeof(output->layers) / sizeof(output->layers[0]);
+				++i) {
+			struct sway_layer_surface *sway_layer;
+			wl_list_for_each(sway_layer, &output->layers[i], link) {
+				struct wlr_surface *surface =
+					sway_layer->layer_surface->surface;
+				account(usage, get_client(usage, surface),
+						MEMORY_LAYER_SURFACES, surface_bytes(surface));
+			}
+		}
+	}
+}
+
+void memory_usage_finish(struct sway_memory_usage *usage) {
+	list_free_items_and_destroy(usage->clients);
+	usage->clients = NULL;
+}
+
+size_t memory_usage_total(struct sway_memory_usage *usage) {
+	size_t total = 0;
+	for (int i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		total += usage->bytes[i];
+	}
+	return total;
+}
+
+/**
+ * Client buffers and layer surfaces aren't ours to drop, and saved buffers
+ * only exist while their transaction is in flight, so only the textures count
+ * towards the budget.
+ */
+static size_t memory_usage_evictable(struct sway_memory_usage *usage) {
+	return usage->bytes[MEMORY_TITLE_TEXTURES] +
+		usage->bytes[MEMORY_MARKS_TEXTURES];
+}
+
+const struct sway_memory_evictions *memory_get_evictions(void) {
+	return &evictions;
+}
+
+static bool container_is_hidden(struct sway_container *con) {
+	// Titles of hidden tabs are still drawn in the tab bar, so only the
+	// workspace matters here
+	return !con->workspace || !workspace_is_visible(con->workspace);
+}
+
+static bool container_is_shown(struct sway_container *con) {
+	// What's on screen during a transaction is the current state
+	struct sway_workspace *ws = con->current.workspace;
+	if (!ws) {
+		// Hidden scratchpad containers have no workspace, but a global
+		// fullscreen container doesn't have one either
+		return con->current.fullscreen_mode == FULLSCREEN_GLOBAL;
+	}
+	struct sway_output *output = ws->current.output;
+	return output && output->current.active_workspace == ws;
+}
+
+static void destroy_texture(struct wlr_texture **texture) {
+	if (*texture) {
+		wlr_texture_destroy(*texture);
+		*texture = NULL;
+	}
+}
+
+struct eviction_state {
+	size_t excess;
+	size_t freed;
+};
+
+static void evict_textures_iterator(struct sway_container *con, void *data) {
+	struct eviction_state *state = data;
+	// The textures must be hidden in the current state, which is on screen,
+	// and in the pending one, which is about to be
+	if (state->freed >= state->excess || con->textures_evicted ||
+			!container_is_hidden(con) || container_is_shown(con)) {
+		return;
+	}
+	size_t bytes = container_title_bytes(con) + container_marks_bytes(con);
+	if (!bytes) {
+		return;
+	}
+	destroy_texture(&con->title_focused);
+	destroy_texture(&con->title_focused_inactive);
+	destroy_texture(&con->title_unfocused);
+	destroy_texture(&con->title_urgent);
+	destroy_texture(&con->marks_focused);
+	destroy_texture(&con->marks_focused_inactive);
+	destroy_texture(&con->marks_unfocused);
+	destroy_texture(&con->marks_urgent);
+	con->textures_evicted = true;
+	state->freed += bytes;
+	evictions.title_textures++;
+}
+
+static void handle_budget_check(void *data) {
+	budget_check_source = NULL;
+	if (!config || !config->memory_budget) {
+		return;
+	}
+
+	struct sway_memory_usage usage;
+	memory_usage_collect(&usage);
+	size_t total = memory_usage_evictable(&usage);
+	memory_usage_finish(&usage);
+	if (total <= config->memory_budget) {
+		return;
+	}
+
+	struct eviction_state state = {
+		.excess = total - config->memory_budget,
+	};
+	root_for_each_container(evict_textures_iterator, &state);
+	sway_log(SWAY_DEBUG, "Evictable memory %zu exceeds budget %zu, "
+			"evicted %zu bytes", total, config->memory_budget, state.freed);
+}
+
+void memory_budget_schedule_check(void) {
+	if (budget_check_source || !config || !config->memory_budget) {
+		return;
+	}
+	budget_check_source = wl_event_loop_add_idle(server.wl_event_loop,
+			handle_budget_check, NULL);
+}
+
+void memory_restore_container(struct sway_container *con) {
+	if (!con->textures_evicted || con->node.destroying ||
+			container_is_hidden(con)) {
+		return;
+	}
+	con->textures_evicted = false;
+	container_update_title_textures(con);
+	container_update_marks_textures(con);
+}
+
+static void restore_container_iterator(struct sway_container *con,
+		void *data) {
+	memory_restore_container(con);
+}
+
+void memory_restore_workspace(struct sway_workspace *ws) {
+	workspace_for_each_container(ws, restore_container_iterator, NULL);
+}
@@ -16,6 +16,7 @@
 #include <wlr/util/region.h>
 #include "config.h"
 #include "log.h"
+#include "sway/benchmark.h"
 #include "sway/config.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
@@ -23,6 +24,7 @@
 #include "sway/layers.h"
 #include "sway/output.h"
 #include "sway/server.h"
+#include "sway/trace.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
 #include "sway/tree/root.h"
@@ -211,12 +213,25 @@ void output_layer_for_each_surface(struct sway_output *output,
 void output_unmanaged_for_each_surface(struct sway_output *output,
 		struct wl_list *unmanaged, sway_surface_iterator_func_t iterator,
 		void *user_data) {
+	struct wlr_box output_box = {
+		.x = output->lx,
+		.y = output->ly,
+		.width = output->width,
+		.height = output->height,
+	};
 	struct sway_xwayland_unmanaged *unmanaged_surface;
 	wl_list_for_each(unmanaged_surface, unmanaged, link) {
+		// Override-redirect windows have no subsurfaces, so the box covers
+		// everything we would iterate
+		struct wlr_box intersection;
+		if (!wlr_box_intersection(&intersection, &output_box,
+					&unmanaged_surface->box)) {
+			continue;
+		}
 		struct wlr_xwayland_surface *xsurface =
 			unmanaged_surface->wlr_xwayland_surface;
-		double ox = unmanaged_surface->lx - output->lx;
-		double oy = unmanaged_surface->ly - output->ly;
+		double ox = unmanaged_surface->box.x - output->lx;
+		double oy = unmanaged_surface->box.y - output->ly;
 
 		output_surface_for_each_surface(output, xsurface->surface, ox, oy,
 			iterator, user_data);
@@ -399,9 +414,14 @@ static void damage_handle_frame(struct wl_listener *listener, void *data) {
 		return;
 	}
 
+	trace_record(TRACE_FRAME, TRACE_BEGIN, output->node.id, needs_frame);
 	if (needs_frame) {
 		output_render(output, &now, &damage);
+		if (benchmark_is_running()) {
+			benchmark_record(BENCHMARK_FRAME, &now);
+		}
 	}
+	trace_record(TRACE_FRAME, TRACE_END, output->node.id, needs_frame);
 
 	pixman_region32_fini(&damage);
 
@@ -429,7 +449,8 @@ static void damage_surface_iterator(struct sway_output *output,
 	int center_x = box.x + box.width/2;
 	int center_y = box.y + box.height/2;
 
-	if (pixman_region32_not_empty(&surface->buffer_damage)) {
+	bool damaged = pixman_region32_not_empty(&surface->buffer_damage);
+	if (damaged) {
 		pixman_region32_t damage;
 		pixman_region32_init(&damage);
 		wlr_surface_get_effective_damage(surface, &damage);
@@ -452,7 +473,12 @@ static void damage_surface_iterator(struct sway_output *output,
 		wlr_output_damage_add_box(output->damage, &box);
 	}
 
-	wlr_output_schedule_frame(output->wlr_output);
+	// Commits without new damage still need a frame if the client is waiting
+	// for a frame callback, otherwise there's nothing to render
+	if (damaged || whole ||
+			!wl_list_empty(&surface->current.frame_callback_list)) {
+		wlr_output_schedule_frame(output->wlr_output);
+	}
 }
 
 void output_damage_surface(struct sway_output *output, double ox, double oy,
@@ -463,9 +489,6 @@ void output_damage_surface(struct sway_output *output, double ox, double oy,
 
 void output_damage_from_view(struct sway_output *output,
 		struct sway_view *view) {
-	if (!view_is_visible(view)) {
-		return;
-	}
 	bool whole = false;
 	output_view_for_each_surface(output, view, damage_surface_iterator, &whole);
 }
@@ -585,6 +608,10 @@ static void handle_mode(struct wl_listener *listener, void *data) {
 	if (!output->enabled || !output->configured) {
 		return;
 	}
+	if (output_config_batch_is_open()) {
+		output->batch_needs_arrange = true;
+		return;
+	}
 	arrange_layers(output);
 	arrange_output(output);
 	transaction_commit_dirty();
@@ -597,6 +624,10 @@ static void handle_transform(struct wl_listener *listener, void *data) {
 	if (!output->enabled || !output->configured) {
 		return;
 	}
+	if (output_config_batch_is_open()) {
+		output->batch_needs_arrange = true;
+		return;
+	}
 	arrange_layers(output);
 	arrange_output(output);
 	transaction_commit_dirty();
@@ -609,11 +640,69 @@ static void update_textures(struct sway_container *con, void *data) {
 	container_update_marks_textures(con);
 }
 
+static struct {
+	int depth;
+	bool needs_arrange;
+} output_config_batch;
+
+void output_config_batch_begin(void) {
+	output_config_batch.depth++;
+}
+
+bool output_config_batch_is_open(void) {
+	return output_config_batch.depth > 0;
+}
+
+void output_config_batch_end(void) {
+	if (!sway_assert(output_config_batch.depth > 0,
+				"Output configuration batch is not open")) {
+		return;
+	}
+	if (--output_config_batch.depth > 0) {
+		return;
+	}
+
+	bool needs_arrange = output_config_batch.needs_arrange;
+	output_config_batch.needs_arrange = false;
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		if (output->batch_needs_arrange) {
+			arrange_layers(output);
+			needs_arrange = true;
+		}
+		if (output->batch_needs_textures) {
+			output_for_each_container(output, update_textures, NULL);
+		}
+		output->batch_needs_arrange = output->batch_needs_textures = false;
+	}
+	if (!needs_arrange) {
+		return;
+	}
+
+	arrange_root();
+	transaction_commit_dirty();
+
+	update_output_manager_config(&server);
+}
+
+bool output_config_batch_defer_arrange(void) {
+	if (!output_config_batch_is_open()) {
+		return false;
+	}
+	output_config_batch.needs_arrange = true;
+	return true;
+}
+
 static void handle_scale(struct wl_listener *listener, void *data) {
 	struct sway_output *output = wl_container_of(listener, output, scale);
 	if (!output->enabled || !output->configured) {
 		return;
 	}
+	if (output_config_batch_is_open()) {
+		output->batch_needs_arrange = true;
+		output->batch_needs_textures = true;
+		return;
+	}
 	arrange_layers(output);
 	output_for_each_container(output, update_textures, NULL);
 	arrange_output(output);
@@ -688,11 +777,59 @@ void handle_new_output(struct wl_listener *listener, void *data) {
 	update_output_manager_config(server);
 }
 
+static struct output_config *output_config_for_config_head(
+		struct wlr_output_configuration_head_v1 *config_head) {
+	struct wlr_output *wlr_output = config_head->state.output;
+	struct output_config *oc = new_output_config(wlr_output->name);
+	oc->enabled = config_head->state.enabled;
+	if (!oc->enabled) {
+		return oc;
+	}
+	if (config_head->state.mode != NULL) {
+		struct wlr_output_mode *mode = config_head->state.mode;
+		oc->width = mode->width;
+		oc->height = mode->height;
+		oc->refresh_rate = mode->refresh;
+	} else {
+		oc->width = config_head->state.custom_mode.width;
+		oc->height = config_head->state.custom_mode.height;
+		oc->refresh_rate = config_head->state.custom_mode.refresh;
+	}
+	oc->x = config_head->state.x;
+	oc->y = config_head->state.y;
+	oc->transform = config_head->state.transform;
+	oc->scale = config_head->state.scale;
+	return oc;
+}
+
+static bool test_output_manager_config(
+		struct wlr_output_configuration_v1 *config) {
+	bool ok = true;
+	struct wlr_output_configuration_head_v1 *config_head;
+	wl_list_for_each(config_head, &config->heads, link) {
+		struct sway_output *output = config_head->state.output->data;
+		struct output_config *oc = output_config_for_config_head(config_head);
+		ok &= test_output_config(oc, output);
+		free_output_config(oc);
+	}
+	return ok;
+}
+
 void handle_output_manager_apply(struct wl_listener *listener, void *data) {
 	struct sway_server *server =
 		wl_container_of(listener, server, output_manager_apply);
 	struct wlr_output_configuration_v1 *config = data;
 
+	// Check the whole configuration before touching any output, so a bad head
+	// doesn't leave the layout half applied
+	if (!test_output_manager_config(config)) {
+		wlr_output_configuration_v1_send_failed(config);
+		wlr_output_configuration_v1_destroy(config);
+		return;
+	}
+
+	output_config_batch_begin();
+
 	struct wlr_output_configuration_head_v1 *config_head;
 	// First disable outputs we need to disable
 	bool ok = true;
@@ -702,9 +839,7 @@ void handle_output_manager_apply(struct wl_listener *listener, void *data) {
 		if (!output->enabled || config_head->state.enabled) {
 			continue;
 		}
-		struct output_config *oc = new_output_config(output->wlr_output->name);
-		oc->enabled = false;
-
+		struct output_config *oc = output_config_for_config_head(config_head);
 		oc = store_output_config(oc);
 		ok &= apply_output_config(oc, output);
 	}
@@ -716,27 +851,13 @@ void handle_output_manager_apply(struct wl_listener *listener, void *data) {
 		if (!config_head->state.enabled) {
 			continue;
 		}
-		struct output_config *oc = new_output_config(output->wlr_output->name);
-		oc->enabled = true;
-		if (config_head->state.mode != NULL) {
-			struct wlr_output_mode *mode = config_head->state.mode;
-			oc->width = mode->width;
-			oc->height = mode->height;
-			oc->refresh_rate = mode->refresh;
-		} else {
-			oc->width = config_head->state.custom_mode.width;
-			oc->height = config_head->state.custom_mode.height;
-			oc->refresh_rate = config_head->state.custom_mode.refresh;
-		}
-		oc->x = config_head->state.x;
-		oc->y = config_head->state.y;
-		oc->transform = config_head->state.transform;
-		oc->scale = config_head->state.scale;
-
+		struct output_config *oc = output_config_for_config_head(config_head);
 		oc = store_output_config(oc);
 		ok &= apply_output_config(oc, output);
 	}
 
+	output_config_batch_end();
+
 	if (ok) {
 		wlr_output_configuration_v1_send_succeeded(config);
 	} else {
@@ -750,7 +871,10 @@ void handle_output_manager_apply(struct wl_listener *listener, void *data) {
 void handle_output_manager_test(struct wl_listener *listener, void *data) {
 	struct wlr_output_configuration_v1 *config = data;
 
-	// TODO: implement test-only mode
-	wlr_output_configuration_v1_send_succeeded(config);
+	if (test_output_manager_config(config)) {
+		wlr_output_configuration_v1_send_succeeded(config);
+	} else {
+		wlr_output_configuration_v1_send_failed(config);
+	}
 	wlr_output_configuration_v1_destroy(config);
 }
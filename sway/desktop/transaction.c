@@ -4,13 +4,16 @@
 #include <string.h>
 #include <time.h>
 #include <wlr/types/wlr_buffer.h>
+#include "sway/benchmark.h"
 #include "sway/config.h"
 #include "sway/desktop.h"
 #include "sway/desktop/idle_inhibit_v1.h"
+#include "sway/desktop/memory.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
 #include "sway/output.h"
+#include "sway/trace.h"
 #include "sway/tree/container.h"
 #include "sway/tree/node.h"
 #include "sway/tree/view.h"
@@ -24,6 +27,7 @@ struct sway_transaction {
 	size_t num_waiting;
 	size_t num_configures;
 	struct timespec commit_time;
+	uint32_t id; // for tracing
 };
 
 struct sway_transaction_instruction {
@@ -38,12 +42,14 @@ struct sway_transaction_instruction {
 };
 
 static struct sway_transaction *transaction_create(void) {
+	static uint32_t next_id = 1;
 	struct sway_transaction *transaction =
 		calloc(1, sizeof(struct sway_transaction));
 	if (!sway_assert(transaction, "Unable to allocate transaction")) {
 		return NULL;
 	}
 	transaction->instructions = create_list();
+	transaction->id = next_id++;
 	return transaction;
 }
 
@@ -193,6 +199,9 @@ static void apply_output_state(struct sway_output *output,
 	output_damage_whole(output);
 	list_free(output->current.workspaces);
 	memcpy(&output->current, state, sizeof(struct sway_output_state));
+	if (output->current.active_workspace) {
+		memory_restore_workspace(output->current.active_workspace);
+	}
 	output_damage_whole(output);
 }
 
@@ -235,6 +244,8 @@ static void apply_container_state(struct sway_container *container,
 		}
 	}
 
+	memory_restore_container(container);
+
 	// Damage the new location
 	desktop_damage_whole_container(container);
 	if (view && view->surface) {
@@ -287,6 +298,11 @@ static void transaction_apply(struct sway_transaction *transaction) {
 		sway_log(SWAY_DEBUG, "Transaction %p: %.1fms waiting "
 				"(%.1f frames if 60Hz)", transaction, ms, ms / (1000.0f / 60));
 	}
+	if (benchmark_is_running()) {
+		benchmark_record(BENCHMARK_TRANSACTION, &transaction->commit_time);
+	}
+	trace_record(TRACE_TRANSACTION, TRACE_END, transaction->id,
+			transaction->instructions->length);
 
 	// Apply the instruction state to the node's current state
 	for (int i = 0; i < transaction->instructions->length; ++i) {
@@ -375,6 +391,8 @@ static int handle_timeout(void *data) {
 	struct sway_transaction *transaction = data;
 	sway_log(SWAY_DEBUG, "Transaction %p timed out (%zi waiting)",
 			transaction, transaction->num_waiting);
+	trace_record(TRACE_TRANSACTION_TIMEOUT, TRACE_INSTANT, transaction->id,
+			transaction->num_waiting);
 	transaction->num_waiting = 0;
 	transaction_progress_queue();
 	return 0;
@@ -407,9 +425,30 @@ static bool should_configure(struct sway_node *node,
 	return true;
 }
 
+/**
+ * Xwayland views are told their position, but a configure which only moves
+ * them doesn't change their buffer. Optionally treat such configures as
+ * fire-and-forget so floating drags don't wait on the X server.
+ */
+static bool should_wait_for_configure(struct sway_node *node,
+		struct sway_transaction_instruction *instruction) {
+#if HAVE_XWAYLAND
+	if (debug.xwayland_nowait &&
+			node->sway_container->view->type == SWAY_VIEW_XWAYLAND) {
+		struct sway_container_state *cstate = &node->sway_container->current;
+		struct sway_container_state *istate = &instruction->container_state;
+		return cstate->content_width != istate->content_width ||
+			cstate->content_height != istate->content_height;
+	}
+#endif
+	return true;
+}
+
 static void transaction_commit(struct sway_transaction *transaction) {
 	sway_log(SWAY_DEBUG, "Transaction %p committing with %i instructions",
 			transaction, transaction->instructions->length);
+	trace_record(TRACE_TRANSACTION, TRACE_BEGIN, transaction->id,
+			transaction->instructions->length);
 	transaction->num_waiting = 0;
 	for (int i = 0; i < transaction->instructions->length; ++i) {
 		struct sway_transaction_instruction *instruction =
@@ -421,6 +460,13 @@ static void transaction_commit(struct sway_transaction *transaction) {
 					instruction->container_state.content_y,
 					instruction->container_state.content_width,
 					instruction->container_state.content_height);
+			trace_record(TRACE_CONFIGURE, TRACE_INSTANT, node->id,
+					instruction->serial);
+			if (!should_wait_for_configure(node, instruction)) {
+				// The buffer isn't going to change, so there's nothing to save
+				// and no ack to match against this instruction
+				continue;
+			}
 			++transaction->num_waiting;
 
 			// From here on we are rendering a saved buffer of the view, which
@@ -441,7 +487,7 @@ static void transaction_commit(struct sway_transaction *transaction) {
 		node->instruction = instruction;
 	}
 	transaction->num_configures = transaction->num_waiting;
-	if (debug.txn_timings) {
+	if (debug.txn_timings || benchmark_is_running()) {
 		clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
 	}
 	if (debug.noatomic) {
@@ -470,6 +516,8 @@ static void transaction_commit(struct sway_transaction *transaction) {
 static void set_instruction_ready(
 		struct sway_transaction_instruction *instruction) {
 	struct sway_transaction *transaction = instruction->transaction;
+	trace_record(TRACE_ACK, TRACE_INSTANT, instruction->node->id,
+			instruction->serial);
 
 	if (debug.txn_timings) {
 		struct timespec now;
@@ -513,14 +561,15 @@ void transaction_notify_view_ready_by_size(struct sway_view *view,
 	}
 }
 
-void transaction_commit_dirty(void) {
+uint32_t transaction_commit_dirty(void) {
 	if (!server.dirty_nodes->length) {
-		return;
+		return 0;
 	}
 	struct sway_transaction *transaction = transaction_create();
 	if (!transaction) {
-		return;
+		return 0;
 	}
+	uint32_t id = transaction->id;
 	for (int i = 0; i < server.dirty_nodes->length; ++i) {
 		struct sway_node *node = server.dirty_nodes->items[i];
 		transaction_add_node(transaction, node);
@@ -538,4 +587,15 @@ void transaction_commit_dirty(void) {
 		// if the transaction has nothing to wait for.
 		transaction_progress_queue();
 	}
+	return id;
+}
+
+bool transaction_is_pending(uint32_t id) {
+	for (int i = 0; i < server.transactions->length; ++i) {
+		struct sway_transaction *transaction = server.transactions->items[i];
+		if (transaction->id == id) {
+			return true;
+		}
+	}
+	return false;
 }
@@ -2,6 +2,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <wayland-server.h>
+#include <wlr/types/wlr_box.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/xwayland.h>
@@ -41,22 +42,49 @@ static void unmanaged_handle_request_configure(struct wl_listener *listener,
 		ev->width, ev->height);
 }
 
+static void unmanaged_get_box(struct sway_xwayland_unmanaged *surface,
+		struct wlr_box *box) {
+	struct wlr_xwayland_surface *xsurface = surface->wlr_xwayland_surface;
+	box->x = xsurface->x;
+	box->y = xsurface->y;
+	box->width = xsurface->surface->current.width;
+	box->height = xsurface->surface->current.height;
+}
+
+/**
+ * Damage the surface as if it were at box, on the outputs box intersects.
+ */
+static void unmanaged_damage(struct sway_xwayland_unmanaged *surface,
+		struct wlr_box *box, bool whole) {
+	struct wlr_surface *wlr_surface = surface->wlr_xwayland_surface->surface;
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		struct wlr_box *output_box = wlr_output_layout_get_box(
+			root->output_layout, output->wlr_output);
+		struct wlr_box intersection;
+		if (!wlr_box_intersection(&intersection, output_box, box)) {
+			continue;
+		}
+		output_damage_surface(output, box->x - output_box->x,
+			box->y - output_box->y, wlr_surface, whole);
+	}
+}
+
 static void unmanaged_handle_commit(struct wl_listener *listener, void *data) {
 	struct sway_xwayland_unmanaged *surface =
 		wl_container_of(listener, surface, commit);
-	struct wlr_xwayland_surface *xsurface = surface->wlr_xwayland_surface;
 
-	if (xsurface->x != surface->lx || xsurface->y != surface->ly) {
-		// Surface has moved
-		desktop_damage_surface(xsurface->surface, surface->lx, surface->ly,
-			true);
-		surface->lx = xsurface->x;
-		surface->ly = xsurface->y;
-		desktop_damage_surface(xsurface->surface, surface->lx, surface->ly,
-			true);
+	struct wlr_box old_box = surface->box;
+	unmanaged_get_box(surface, &surface->box);
+
+	if (surface->box.x != old_box.x || surface->box.y != old_box.y ||
+			surface->box.width != old_box.width ||
+			surface->box.height != old_box.height) {
+		// Surface has moved or resized
+		unmanaged_damage(surface, &old_box, true);
+		unmanaged_damage(surface, &surface->box, true);
 	} else {
-		desktop_damage_surface(xsurface->surface, xsurface->x, xsurface->y,
-			false);
+		unmanaged_damage(surface, &surface->box, false);
 	}
 }
 
@@ -70,9 +98,8 @@ static void unmanaged_handle_map(struct wl_listener *listener, void *data) {
 	wl_signal_add(&xsurface->surface->events.commit, &surface->commit);
 	surface->commit.notify = unmanaged_handle_commit;
 
-	surface->lx = xsurface->x;
-	surface->ly = xsurface->y;
-	desktop_damage_surface(xsurface->surface, surface->lx, surface->ly, true);
+	unmanaged_get_box(surface, &surface->box);
+	unmanaged_damage(surface, &surface->box, true);
 
 	if (wlr_xwayland_or_surface_wants_focus(xsurface)) {
 		struct sway_seat *seat = input_manager_current_seat();
@@ -86,7 +113,7 @@ static void unmanaged_handle_unmap(struct wl_listener *listener, void *data) {
 	struct sway_xwayland_unmanaged *surface =
 		wl_container_of(listener, surface, unmap);
 	struct wlr_xwayland_surface *xsurface = surface->wlr_xwayland_surface;
-	desktop_damage_surface(xsurface->surface, xsurface->x, xsurface->y, true);
+	unmanaged_damage(surface, &surface->box, true);
 	wl_list_remove(&surface->link);
 	wl_list_remove(&surface->commit.link);
 
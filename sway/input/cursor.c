@@ -7,6 +7,7 @@
 #include <float.h>
 #include <limits.h>
 #include <strings.h>
+#include <wayland-server-protocol.h>
 #include <wlr/types/wlr_box.h>
 #include <wlr/types/wlr_cursor.h>
 #include <wlr/types/wlr_idle.h>
@@ -22,6 +23,7 @@
 #include "sway/input/keyboard.h"
 #include "sway/layers.h"
 #include "sway/output.h"
+#include "sway/trace.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
 #include "sway/tree/root.h"
@@ -65,11 +67,14 @@ struct sway_node *node_at_coords(
 	struct wl_list *unmanaged = &root->xwayland_unmanaged;
 	struct sway_xwayland_unmanaged *unmanaged_surface;
 	wl_list_for_each_reverse(unmanaged_surface, unmanaged, link) {
+		if (!wlr_box_contains_point(&unmanaged_surface->box, lx, ly)) {
+			continue;
+		}
 		struct wlr_xwayland_surface *xsurface =
 			unmanaged_surface->wlr_xwayland_surface;
 
-		double _sx = lx - unmanaged_surface->lx;
-		double _sy = ly - unmanaged_surface->ly;
+		double _sx = lx - unmanaged_surface->box.x;
+		double _sy = ly - unmanaged_surface->box.y;
 		if (wlr_surface_point_accepts_input(xsurface->surface, _sx, _sy)) {
 			*surface = xsurface->surface;
 			*sx = _sx;
@@ -262,6 +267,7 @@ static void cursor_motion(struct sway_cursor *cursor, uint32_t time_msec,
 static void handle_cursor_motion_relative(
 		struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, motion);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_MOTION);
 	struct wlr_event_pointer_motion *e = data;
 
 	cursor_motion(cursor, e->time_msec, e->device, e->delta_x, e->delta_y,
@@ -273,6 +279,7 @@ static void handle_cursor_motion_absolute(
 		struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor =
 		wl_container_of(listener, cursor, motion_absolute);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_MOTION);
 	struct wlr_event_pointer_motion_absolute *event = data;
 
 	double lx, ly;
@@ -293,11 +300,13 @@ void dispatch_cursor_button(struct sway_cursor *cursor,
 		time_msec = get_current_time_msec();
 	}
 
+	cursor_flush_motion(cursor);
 	seatop_button(cursor->seat, time_msec, device, button, state);
 }
 
 static void handle_cursor_button(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, button);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_BUTTON);
 	struct wlr_event_pointer_button *event = data;
 	cursor_handle_activity(cursor);
 
@@ -323,6 +332,7 @@ void dispatch_cursor_axis(struct sway_cursor *cursor,
 
 static void handle_cursor_axis(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, axis);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_AXIS);
 	struct wlr_event_pointer_axis *event = data;
 	cursor_handle_activity(cursor);
 	dispatch_cursor_axis(cursor, event);
@@ -335,10 +345,154 @@ static void handle_cursor_frame(struct wl_listener *listener, void *data) {
 	wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
 }
 
+static struct sway_touch_point *cursor_get_touch_point(
+		struct sway_cursor *cursor, int32_t touch_id) {
+	for (int i = 0; i < cursor->touch_points->length; ++i) {
+		struct sway_touch_point *point = cursor->touch_points->items[i];
+		if (point->touch_id == touch_id) {
+			return point;
+		}
+	}
+	return NULL;
+}
+
+static void send_touch_motion(struct sway_cursor *cursor,
+		struct sway_touch_point *point) {
+	struct sway_seat *seat = cursor->seat;
+	struct wlr_seat *wlr_seat = seat->wlr_seat;
+	point->motion_pending = false;
+
+	if (seat->touch_id == point->touch_id) {
+		seat->touch_x = point->lx;
+		seat->touch_y = point->ly;
+
+		struct sway_drag_icon *drag_icon;
+		wl_list_for_each(drag_icon, &root->drag_icons, link) {
+			if (drag_icon->seat == seat) {
+				drag_icon_update_position(drag_icon);
+			}
+		}
+	}
+
+	// Only hit test again if the point has left the surface it was last
+	// found on, or if wlroots has dropped the surface (eg. it was destroyed)
+	struct wlr_touch_point *wlr_point =
+		wlr_seat_touch_get_point(wlr_seat, point->touch_id);
+	double sx = point->lx - point->surface_lx;
+	double sy = point->ly - point->surface_ly;
+	if (!point->surface || !wlr_point || wlr_point->surface != point->surface ||
+			!wlr_surface_point_accepts_input(point->surface, sx, sy)) {
+		struct wlr_surface *surface = NULL;
+		node_at_coords(seat, point->lx, point->ly, &surface, &sx, &sy);
+		point->surface = surface;
+		if (!surface) {
+			return;
+		}
+		point->surface_lx = point->lx - sx;
+		point->surface_ly = point->ly - sy;
+	}
+
+	// TODO: fall back to cursor simulation if client has not bound to touch
+	if (seat_is_input_allowed(seat, point->surface)) {
+		wlr_seat_touch_notify_motion(wlr_seat, point->motion_time_msec,
+			point->touch_id, sx, sy);
+		point->frame_pending = true;
+	}
+}
+
+/**
+ * End the burst of motion sent for a flush with a frame, once per client.
+ * wlroots has no call for a touch frame on its own, so it's sent to the
+ * client's wl_touch resources directly.
+ */
+static void send_touch_frames(struct sway_cursor *cursor) {
+	struct wlr_seat *wlr_seat = cursor->seat->wlr_seat;
+	for (int i = 0; i < cursor->touch_points->length; ++i) {
+		struct sway_touch_point *point = cursor->touch_points->items[i];
+		if (!point->frame_pending) {
+			continue;
+		}
+		point->frame_pending = false;
+		struct wlr_touch_point *wlr_point =
+			wlr_seat_touch_get_point(wlr_seat, point->touch_id);
+		if (!wlr_point || !wlr_point->client) {
+			continue;
+		}
+		bool sent = false;
+		for (int j = 0; j < i && !sent; ++j) {
+			struct sway_touch_point *other = cursor->touch_points->items[j];
+			struct wlr_touch_point *wlr_other =
+				wlr_seat_touch_get_point(wlr_seat, other->touch_id);
+			sent = wlr_other && wlr_other->client == wlr_point->client;
+		}
+		if (sent) {
+			continue;
+		}
+		struct wl_resource *resource;
+		wl_resource_for_each(resource, &wlr_point->client->touches) {
+			wl_touch_send_frame(resource);
+		}
+	}
+}
+
+static void send_tool_motion(struct sway_cursor *cursor) {
+	cursor->tool_motion.pending = false;
+
+	double dx = cursor->tool_motion.lx - cursor->cursor->x;
+	double dy = cursor->tool_motion.ly - cursor->cursor->y;
+
+	cursor_motion(cursor, cursor->tool_motion.time_msec,
+			cursor->tool_motion.device, dx, dy, dx, dy);
+	wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
+}
+
+void cursor_flush_motion(struct sway_cursor *cursor) {
+	if (cursor->motion_flush_source) {
+		wl_event_source_remove(cursor->motion_flush_source);
+		cursor->motion_flush_source = NULL;
+	}
+	for (int i = 0; i < cursor->touch_points->length; ++i) {
+		struct sway_touch_point *point = cursor->touch_points->items[i];
+		if (point->motion_pending) {
+			send_touch_motion(cursor, point);
+		}
+	}
+	send_touch_frames(cursor);
+	if (cursor->tool_motion.pending) {
+		send_tool_motion(cursor);
+	}
+}
+
+static void handle_motion_flush(void *data) {
+	struct sway_cursor *cursor = data;
+	cursor->motion_flush_source = NULL;
+	cursor_flush_motion(cursor);
+	transaction_commit_dirty();
+}
+
+/**
+ * Touchscreens and tablets can report motion far more often than outputs
+ * refresh. Only the most recent position of each contact is kept, and it's
+ * sent once all the input events which are currently queued are dispatched.
+ */
+static void schedule_motion_flush(struct sway_cursor *cursor) {
+	if (cursor->motion_flush_source) {
+		return;
+	}
+	cursor->motion_flush_source = wl_event_loop_add_idle(
+			server.wl_event_loop, handle_motion_flush, cursor);
+	if (!cursor->motion_flush_source) {
+		sway_log(SWAY_ERROR, "Unable to create motion flush source");
+		cursor_flush_motion(cursor);
+	}
+}
+
 static void handle_touch_down(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, touch_down);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_TOUCH);
 	wlr_idle_notify_activity(server.idle, cursor->seat->wlr_seat);
 	struct wlr_event_touch_down *event = data;
+	cursor_flush_motion(cursor);
 
 	struct sway_seat *seat = cursor->seat;
 	struct wlr_seat *wlr_seat = seat->wlr_seat;
@@ -354,9 +508,26 @@ static void handle_touch_down(struct wl_listener *listener, void *data) {
 	seat->touch_x = lx;
 	seat->touch_y = ly;
 
+	struct sway_touch_point *point =
+		cursor_get_touch_point(cursor, event->touch_id);
+	if (!point) {
+		point = calloc(1, sizeof(struct sway_touch_point));
+		if (!sway_assert(point, "Unable to allocate touch point")) {
+			return;
+		}
+		point->touch_id = event->touch_id;
+		list_add(cursor->touch_points, point);
+	}
+	point->device = event->device;
+	point->surface = surface;
+	point->lx = lx;
+	point->ly = ly;
+
 	if (!surface) {
 		return;
 	}
+	point->surface_lx = lx - sx;
+	point->surface_ly = ly - sy;
 
 	// TODO: fall back to cursor simulation if client has not bound to touch
 	if (seat_is_input_allowed(seat, surface)) {
@@ -368,50 +539,62 @@ static void handle_touch_down(struct wl_listener *listener, void *data) {
 
 static void handle_touch_up(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, touch_up);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_TOUCH);
 	wlr_idle_notify_activity(server.idle, cursor->seat->wlr_seat);
 	struct wlr_event_touch_up *event = data;
+	cursor_flush_motion(cursor);
+
+	for (int i = 0; i < cursor->touch_points->length; ++i) {
+		struct sway_touch_point *point = cursor->touch_points->items[i];
+		if (point->touch_id == event->touch_id) {
+			list_del(cursor->touch_points, i);
+			free(point);
+			break;
+		}
+	}
+
 	struct wlr_seat *seat = cursor->seat->wlr_seat;
 	// TODO: fall back to cursor simulation if client has not bound to touch
 	wlr_seat_touch_notify_up(seat, event->time_msec, event->touch_id);
 }
 
+void cursor_remove_touch_device(struct sway_cursor *cursor,
+		struct wlr_input_device *device) {
+	cursor_flush_motion(cursor);
+	uint32_t time_msec = get_current_time_msec();
+	for (int i = 0; i < cursor->touch_points->length; ++i) {
+		struct sway_touch_point *point = cursor->touch_points->items[i];
+		if (point->device != device) {
+			continue;
+		}
+		if (wlr_seat_touch_get_point(cursor->seat->wlr_seat,
+					point->touch_id)) {
+			wlr_seat_touch_notify_up(cursor->seat->wlr_seat, time_msec,
+					point->touch_id);
+		}
+		list_del(cursor->touch_points, i--);
+		free(point);
+	}
+}
+
 static void handle_touch_motion(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor =
 		wl_container_of(listener, cursor, touch_motion);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_TOUCH);
 	wlr_idle_notify_activity(server.idle, cursor->seat->wlr_seat);
 	struct wlr_event_touch_motion *event = data;
 
-	struct sway_seat *seat = cursor->seat;
-	struct wlr_seat *wlr_seat = seat->wlr_seat;
-	struct wlr_surface *surface = NULL;
-
-	double lx, ly;
-	wlr_cursor_absolute_to_layout_coords(cursor->cursor, event->device,
-			event->x, event->y, &lx, &ly);
-	double sx, sy;
-	node_at_coords(cursor->seat, lx, ly, &surface, &sx, &sy);
-
-	if (seat->touch_id == event->touch_id) {
-		seat->touch_x = lx;
-		seat->touch_y = ly;
-
-		struct sway_drag_icon *drag_icon;
-		wl_list_for_each(drag_icon, &root->drag_icons, link) {
-			if (drag_icon->seat == seat) {
-				drag_icon_update_position(drag_icon);
-			}
-		}
-	}
-
-	if (!surface) {
+	struct sway_touch_point *point =
+		cursor_get_touch_point(cursor, event->touch_id);
+	if (!point) {
 		return;
 	}
 
-	// TODO: fall back to cursor simulation if client has not bound to touch
-	if (seat_is_input_allowed(cursor->seat, surface)) {
-		wlr_seat_touch_notify_motion(wlr_seat, event->time_msec,
-			event->touch_id, sx, sy);
-	}
+	wlr_cursor_absolute_to_layout_coords(cursor->cursor, event->device,
+			event->x, event->y, &point->lx, &point->ly);
+	point->motion_time_msec = event->time_msec;
+	point->motion_pending = true;
+	schedule_motion_flush(cursor);
 }
 
 static double apply_mapping_from_coord(double low, double high, double value) {
@@ -443,6 +626,7 @@ static void apply_mapping_from_region(struct wlr_input_device *device,
 
 static void handle_tool_axis(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, tool_axis);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_TABLET);
 	wlr_idle_notify_activity(server.idle, cursor->seat->wlr_seat);
 	struct wlr_event_tablet_tool_axis *event = data;
 	struct sway_input_device *input_device = event->device->data;
@@ -464,18 +648,26 @@ static void handle_tool_axis(struct wl_listener *listener, void *data) {
 	wlr_cursor_absolute_to_layout_coords(cursor->cursor, event->device,
 			x, y, &lx, &ly);
 
-	double dx = lx - cursor->cursor->x;
-	double dy = ly - cursor->cursor->y;
-
-	cursor_motion(cursor, event->time_msec, event->device, dx, dy, dx, dy);
-	wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
-	transaction_commit_dirty();
+	// Axes which weren't updated keep the position of any motion which hasn't
+	// been applied to the cursor yet
+	if (!cursor->tool_motion.pending || !isnan(x)) {
+		cursor->tool_motion.lx = lx;
+	}
+	if (!cursor->tool_motion.pending || !isnan(y)) {
+		cursor->tool_motion.ly = ly;
+	}
+	cursor->tool_motion.time_msec = event->time_msec;
+	cursor->tool_motion.device = event->device;
+	cursor->tool_motion.pending = true;
+	schedule_motion_flush(cursor);
 }
 
 static void handle_tool_tip(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, tool_tip);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_TABLET);
 	wlr_idle_notify_activity(server.idle, cursor->seat->wlr_seat);
 	struct wlr_event_tablet_tool_tip *event = data;
+	cursor_flush_motion(cursor);
 	dispatch_cursor_button(cursor, event->device, event->time_msec,
 			BTN_LEFT, event->state == WLR_TABLET_TOOL_TIP_DOWN ?
 				WLR_BUTTON_PRESSED : WLR_BUTTON_RELEASED);
@@ -485,8 +677,10 @@ static void handle_tool_tip(struct wl_listener *listener, void *data) {
 
 static void handle_tool_button(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, tool_button);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_TABLET);
 	wlr_idle_notify_activity(server.idle, cursor->seat->wlr_seat);
 	struct wlr_event_tablet_tool_button *event = data;
+	cursor_flush_motion(cursor);
 	// TODO: the user may want to configure which tool buttons are mapped to
 	// which simulated pointer buttons
 	switch (event->state) {
@@ -579,6 +773,74 @@ static void handle_request_set_cursor(struct wl_listener *listener,
 			event->hotspot_y, focused_client);
 }
 
+struct xcursor_cache_entry {
+	char *theme; // NULL for the default theme
+	unsigned size;
+	struct wlr_xcursor_manager *manager;
+	int refs;
+};
+
+static list_t *xcursor_cache; // struct xcursor_cache_entry
+
+static bool theme_name_equal(const char *a, const char *b) {
+	return (!a && !b) || (a && b && strcmp(a, b) == 0);
+}
+
+struct wlr_xcursor_manager *xcursor_manager_acquire(const char *theme,
+		unsigned size) {
+	if (!xcursor_cache) {
+		xcursor_cache = create_list();
+	}
+	for (int i = 0; i < xcursor_cache->length; ++i) {
+		struct xcursor_cache_entry *entry = xcursor_cache->items[i];
+		if (entry->size == size && theme_name_equal(entry->theme, theme)) {
+			++entry->refs;
+			return entry->manager;
+		}
+	}
+
+	struct xcursor_cache_entry *entry =
+		calloc(1, sizeof(struct xcursor_cache_entry));
+	if (!sway_assert(entry, "Unable to allocate XCursor cache entry")) {
+		return NULL;
+	}
+	entry->manager = wlr_xcursor_manager_create(theme, size);
+	if (!entry->manager) {
+		free(entry);
+		return NULL;
+	}
+	entry->theme = theme ? strdup(theme) : NULL;
+	entry->size = size;
+	entry->refs = 1;
+	list_add(xcursor_cache, entry);
+	sway_log(SWAY_DEBUG, "Created XCursor manager for theme %s, size %u",
+			theme ? theme : "(default)", size);
+	return entry->manager;
+}
+
+void xcursor_manager_release(struct wlr_xcursor_manager *manager) {
+	if (!manager || !xcursor_cache) {
+		return;
+	}
+	for (int i = 0; i < xcursor_cache->length; ++i) {
+		struct xcursor_cache_entry *entry = xcursor_cache->items[i];
+		if (entry->manager != manager) {
+			continue;
+		}
+		if (--entry->refs == 0) {
+			wlr_xcursor_manager_destroy(entry->manager);
+			free(entry->theme);
+			free(entry);
+			list_del(xcursor_cache, i);
+		}
+		break;
+	}
+	if (xcursor_cache->length == 0) {
+		list_free(xcursor_cache);
+		xcursor_cache = NULL;
+	}
+}
+
 void cursor_set_image(struct sway_cursor *cursor, const char *image,
 		struct wl_client *client) {
 	if (!(cursor->seat->wlr_seat->capabilities & WL_SEAT_CAPABILITY_POINTER)) {
@@ -629,6 +891,10 @@ void sway_cursor_destroy(struct sway_cursor *cursor) {
 	}
 
 	wl_event_source_remove(cursor->hide_source);
+	if (cursor->motion_flush_source) {
+		wl_event_source_remove(cursor->motion_flush_source);
+	}
+	list_free_items_and_destroy(cursor->touch_points);
 
 	wl_list_remove(&cursor->motion.link);
 	wl_list_remove(&cursor->motion_absolute.link);
@@ -643,7 +909,7 @@ void sway_cursor_destroy(struct sway_cursor *cursor) {
 	wl_list_remove(&cursor->tool_button.link);
 	wl_list_remove(&cursor->request_set_cursor.link);
 
-	wlr_xcursor_manager_destroy(cursor->xcursor_manager);
+	xcursor_manager_release(cursor->xcursor_manager);
 	wlr_cursor_destroy(cursor->cursor);
 	free(cursor);
 }
@@ -669,6 +935,8 @@ struct sway_cursor *sway_cursor_create(struct sway_seat *seat) {
 	cursor->hide_source = wl_event_loop_add_timer(server.wl_event_loop,
 			hide_notify, cursor);
 
+	cursor->touch_points = create_list();
+
 	// input events
 	wl_signal_add(&wlr_cursor->events.motion, &cursor->motion);
 	cursor->motion.notify = handle_cursor_motion_relative;
@@ -12,6 +12,7 @@
 #include "sway/input/keyboard.h"
 #include "sway/input/seat.h"
 #include "sway/ipc-server.h"
+#include "sway/trace.h"
 #include "log.h"
 
 static struct modifier_key {
@@ -291,6 +292,9 @@ void sway_keyboard_disarm_key_repeat(struct sway_keyboard *keyboard) {
 		return;
 	}
 	keyboard->repeat_binding = NULL;
+	cmd_program_destroy(keyboard->repeat_program);
+	keyboard->repeat_program = NULL;
+	keyboard->repeat_transaction = 0;
 	if (wl_event_source_timer_update(keyboard->key_repeat_source, 0) < 0) {
 		sway_log(SWAY_DEBUG, "failed to disarm key repeat timer");
 	}
@@ -299,6 +303,7 @@ void sway_keyboard_disarm_key_repeat(struct sway_keyboard *keyboard) {
 static void handle_keyboard_key(struct wl_listener *listener, void *data) {
 	struct sway_keyboard *keyboard =
 		wl_container_of(listener, keyboard, keyboard_key);
+	trace_record(TRACE_INPUT, TRACE_INSTANT, 0, TRACE_INPUT_KEY);
 	struct sway_seat* seat = keyboard->seat_device->sway_seat;
 	struct wlr_seat *wlr_seat = seat->wlr_seat;
 	struct wlr_input_device *wlr_device =
@@ -383,7 +388,12 @@ static void handle_keyboard_key(struct wl_listener *listener, void *data) {
 	// Set up (or clear) keyboard repeat for a pressed binding. Since the
 	// binding may remove the keyboard, the timer needs to be updated first
 	if (binding && wlr_device->keyboard->repeat_info.delay > 0) {
+		if (keyboard->repeat_binding != binding) {
+			cmd_program_destroy(keyboard->repeat_program);
+			keyboard->repeat_program = cmd_program_compile(binding->command);
+		}
 		keyboard->repeat_binding = binding;
+		keyboard->repeat_transaction = 0;
 		if (wl_event_source_timer_update(keyboard->key_repeat_source,
 				wlr_device->keyboard->repeat_info.delay) < 0) {
 			sway_log(SWAY_DEBUG, "failed to set key repeat timer");
@@ -433,9 +443,22 @@ static int handle_keyboard_repeat(void *data) {
 			}
 		}
 
-		seat_execute_command(keyboard->seat_device->sway_seat,
-				keyboard->repeat_binding);
-		transaction_commit_dirty();
+		// While the previous repeat's transaction is still waiting on clients,
+		// the tick is dropped. At most one repeat runs per tick, and none
+		// until the clients have caught up, so the work done is bounded by how
+		// fast they keep up rather than by the rate.
+		if (keyboard->repeat_transaction &&
+				transaction_is_pending(keyboard->repeat_transaction)) {
+			return 0;
+		}
+
+		// The command might disarm the repeat
+		seat_execute_command_program(keyboard->seat_device->sway_seat,
+				keyboard->repeat_binding, keyboard->repeat_program);
+		uint32_t id = transaction_commit_dirty();
+		if (keyboard->repeat_binding) {
+			keyboard->repeat_transaction = id;
+		}
 	}
 	return 0;
 }
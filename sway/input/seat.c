@@ -725,6 +725,8 @@ void seat_remove_device(struct sway_seat *seat,
 	sway_log(SWAY_DEBUG, "removing device %s from seat %s",
 		input_device->identifier, seat->wlr_seat->name);
 
+	// Batched tablet motion and touch points hold a reference to their device
+	cursor_remove_touch_device(seat->cursor, input_device->wlr_device);
 	seat_device_destroy(seat_device);
 
 	seat_update_capabilities(seat);
@@ -763,10 +765,11 @@ void seat_configure_xcursor(struct sway_seat *seat) {
 					cursor_theme) ||
 				server.xwayland.xcursor_manager->size != cursor_size)) {
 
-			wlr_xcursor_manager_destroy(server.xwayland.xcursor_manager);
-
+			// Acquire first, so a manager shared with a seat isn't destroyed
+			struct wlr_xcursor_manager *old = server.xwayland.xcursor_manager;
 			server.xwayland.xcursor_manager =
-				wlr_xcursor_manager_create(cursor_theme, cursor_size);
+				xcursor_manager_acquire(cursor_theme, cursor_size);
+			xcursor_manager_release(old);
 			sway_assert(server.xwayland.xcursor_manager,
 						"Cannot create XCursor manager for theme");
 
@@ -791,13 +794,16 @@ void seat_configure_xcursor(struct sway_seat *seat) {
 				seat->cursor->xcursor_manager, cursor_theme) ||
 			seat->cursor->xcursor_manager->size != cursor_size) {
 
-		wlr_xcursor_manager_destroy(seat->cursor->xcursor_manager);
+		struct wlr_xcursor_manager *old = seat->cursor->xcursor_manager;
 		seat->cursor->xcursor_manager =
-			wlr_xcursor_manager_create(cursor_theme, cursor_size);
+			xcursor_manager_acquire(cursor_theme, cursor_size);
+		xcursor_manager_release(old);
 		sway_assert(seat->cursor->xcursor_manager,
 					"Cannot create XCursor manager for theme");
 	}
 
+	// Scales which are already loaded, by this seat or any other user of the
+	// manager, are skipped
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *sway_output = root->outputs->items[i];
 		struct wlr_output *output = sway_output->wlr_output;
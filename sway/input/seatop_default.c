@@ -1,6 +1,7 @@
 #define _POSIX_C_SOURCE 200809L
 #include <float.h>
 #include <libevdev/libevdev.h>
+#include <stdlib.h>
 #include <wlr/types/wlr_cursor.h>
 #include <wlr/types/wlr_xcursor_manager.h>
 #include "sway/input/cursor.h"
@@ -10,6 +11,7 @@
 
 struct seatop_default_event {
 	struct sway_node *previous_node;
+	struct wlr_surface *previous_surface;
 	uint32_t pressed_buttons[SWAY_CURSOR_PRESSED_BUTTONS_CAP];
 	size_t pressed_button_count;
 };
@@ -97,26 +99,97 @@ static enum wlr_edges find_resize_edge(struct sway_container *cont,
 	return edge;
 }
 
+/**
+ * Orders mouse bindings by release, modifiers and buttons. Bindings which
+ * compare equal only differ by their click region or input device.
+ */
+static int mouse_binding_cmp(const void *_a, const void *_b) {
+	const struct sway_binding *a = *(void **)_a;
+	const struct sway_binding *b = *(void **)_b;
+	uint32_t a_release = a->flags & BINDING_RELEASE;
+	uint32_t b_release = b->flags & BINDING_RELEASE;
+	if (a_release != b_release) {
+		return a_release < b_release ? -1 : 1;
+	}
+	if (a->modifiers != b->modifiers) {
+		return a->modifiers < b->modifiers ? -1 : 1;
+	}
+	if (a->keys->length != b->keys->length) {
+		return a->keys->length < b->keys->length ? -1 : 1;
+	}
+	for (int i = 0; i < a->keys->length; ++i) {
+		uint32_t a_key = *(uint32_t *)a->keys->items[i];
+		uint32_t b_key = *(uint32_t *)b->keys->items[i];
+		if (a_key != b_key) {
+			return a_key < b_key ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+static list_t *get_mouse_binding_index(struct sway_mode *mode) {
+	if (!mode->mouse_binding_index) {
+		mode->mouse_binding_index = create_list();
+		list_cat(mode->mouse_binding_index, mode->mouse_bindings);
+		// Stable, so equal bindings keep their configured precedence
+		list_stable_sort(mode->mouse_binding_index, mouse_binding_cmp);
+	}
+	return mode->mouse_binding_index;
+}
+
 /**
  * Return the mouse binding which matches modifier, click location, release,
  * and pressed button state, otherwise return null.
  */
 static struct sway_binding* get_active_mouse_binding(
-		struct seatop_default_event *e, list_t *bindings, uint32_t modifiers,
-		bool release, bool on_titlebar, bool on_border, bool on_content,
-		bool on_workspace, const char *identifier) {
+		struct seatop_default_event *e, struct sway_mode *mode,
+		uint32_t modifiers, bool release, bool on_titlebar, bool on_border,
+		bool on_content, bool on_workspace, const char *identifier) {
 	uint32_t click_region =
 			((on_titlebar || on_workspace) ? BINDING_TITLEBAR : 0) |
 			((on_border || on_workspace) ? BINDING_BORDER : 0) |
 			((on_content || on_workspace) ? BINDING_CONTENTS : 0);
 
+	list_t *index = get_mouse_binding_index(mode);
+	if (!index->length) {
+		return NULL;
+	}
+
+	void *keys[SWAY_CURSOR_PRESSED_BUTTONS_CAP];
+	for (size_t i = 0; i < e->pressed_button_count; ++i) {
+		keys[i] = &e->pressed_buttons[i];
+	}
+	list_t key_list = {
+		.capacity = e->pressed_button_count,
+		.length = e->pressed_button_count,
+		.items = keys,
+	};
+	struct sway_binding query = {
+		.flags = release ? BINDING_RELEASE : 0,
+		.modifiers = modifiers,
+		.keys = &key_list,
+	};
+	void *query_item = &query;
+	void **found = bsearch(&query_item, index->items, index->length,
+			sizeof(void *), mouse_binding_cmp);
+	if (!found) {
+		return NULL;
+	}
+
+	// Only the run of bindings for this button state needs to be checked
+	int first = found - index->items;
+	while (first > 0 &&
+			mouse_binding_cmp(&query_item, &index->items[first - 1]) == 0) {
+		--first;
+	}
+
 	struct sway_binding *current = NULL;
-	for (int i = 0; i < bindings->length; ++i) {
-		struct sway_binding *binding = bindings->items[i];
-		if (modifiers ^ binding->modifiers ||
-				e->pressed_button_count != (size_t)binding->keys->length ||
-				release != (binding->flags & BINDING_RELEASE) ||
-				!(click_region & binding->flags) ||
+	for (int i = first; i < index->length; ++i) {
+		struct sway_binding *binding = index->items[i];
+		if (mouse_binding_cmp(&query_item, &index->items[i]) != 0) {
+			break;
+		}
+		if (!(click_region & binding->flags) ||
 				(on_workspace &&
 				 (click_region & binding->flags) != click_region) ||
 				(strcmp(binding->input, identifier) != 0 &&
@@ -124,18 +197,6 @@ static struct sway_binding* get_active_mouse_binding(
 			continue;
 		}
 
-		bool match = true;
-		for (size_t j = 0; j < e->pressed_button_count; j++) {
-			uint32_t key = *(uint32_t *)binding->keys->items[j];
-			if (key != e->pressed_buttons[j]) {
-				match = false;
-				break;
-			}
-		}
-		if (!match) {
-			continue;
-		}
-
 		if (!current || strcmp(current->input, "*") == 0) {
 			current = binding;
 			if (strcmp(current->input, identifier) == 0) {
@@ -193,6 +254,7 @@ static void cursor_do_rebase(struct sway_cursor *cursor, uint32_t time_msec,
 		struct sway_node *node, struct wlr_surface *surface,
 		double sx, double sy) {
 	struct wlr_seat *wlr_seat = cursor->seat->wlr_seat;
+	cursor->rebase_stats.full++;
 	if (surface) {
 		if (seat_is_input_allowed(cursor->seat, surface)) {
 			wlr_seat_pointer_notify_enter(wlr_seat, surface, sx, sy);
@@ -258,12 +320,12 @@ static void handle_button(struct sway_seat *seat, uint32_t time_msec,
 	if (state == WLR_BUTTON_PRESSED) {
 		state_add_button(e, button);
 		binding = get_active_mouse_binding(e,
-			config->current_mode->mouse_bindings, modifiers, false,
+			config->current_mode, modifiers, false,
 			on_titlebar, on_border, on_contents, on_workspace,
 			device_identifier);
 	} else {
 		binding = get_active_mouse_binding(e,
-			config->current_mode->mouse_bindings, modifiers, true,
+			config->current_mode, modifiers, true,
 			on_titlebar, on_border, on_contents, on_workspace,
 			device_identifier);
 		state_erase_button(e, button);
@@ -459,7 +521,15 @@ static void handle_motion(struct sway_seat *seat, uint32_t time_msec,
 		check_focus_follows_mouse(seat, e, node);
 	}
 
-	cursor_do_rebase(cursor, time_msec, node, surface, sx, sy);
+	// If the pointer is still over the surface it entered last time, the
+	// client has already chosen the cursor image and only needs the motion
+	if (surface && surface == e->previous_surface &&
+			node == e->previous_node &&
+			surface == seat->wlr_seat->pointer_state.focused_surface) {
+		cursor->rebase_stats.fast_path++;
+	} else {
+		cursor_do_rebase(cursor, time_msec, node, surface, sx, sy);
+	}
 	if (surface && seat_is_input_allowed(cursor->seat, surface)) {
 		wlr_seat_pointer_notify_motion(seat->wlr_seat, time_msec, sx, sy);
 	}
@@ -472,6 +542,7 @@ static void handle_motion(struct sway_seat *seat, uint32_t time_msec,
 	}
 
 	e->previous_node = node;
+	e->previous_surface = surface;
 }
 
 /*--------------------------------\
@@ -529,7 +600,7 @@ static void handle_axis(struct sway_seat *seat,
 	// Handle mouse bindings - x11 mouse buttons 4-7 - press event
 	struct sway_binding *binding = NULL;
 	state_add_button(e, button);
-	binding = get_active_mouse_binding(e, config->current_mode->mouse_bindings,
+	binding = get_active_mouse_binding(e, config->current_mode,
 			modifiers, false, on_titlebar, on_border, on_contents, on_workspace,
 			dev_id);
 	if (binding) {
@@ -570,7 +641,7 @@ static void handle_axis(struct sway_seat *seat,
 	}
 
 	// Handle mouse bindings - x11 mouse buttons 4-7 - release event
-	binding = get_active_mouse_binding(e, config->current_mode->mouse_bindings,
+	binding = get_active_mouse_binding(e, config->current_mode,
 			modifiers, true, on_titlebar, on_border, on_contents, on_workspace,
 			dev_id);
 	state_erase_button(e, button);
@@ -598,6 +669,7 @@ static void handle_rebase(struct sway_seat *seat, uint32_t time_msec) {
 	double sx = 0.0, sy = 0.0;
 	e->previous_node = node_at_coords(seat,
 			cursor->cursor->x, cursor->cursor->y, &surface, &sx, &sy);
+	e->previous_surface = surface;
 	cursor_do_rebase(cursor, time_msec, e->previous_node, surface, sx, sy);
 }
 
@@ -1,18 +1,65 @@
 #define _POSIX_C_SOURCE 200809L
+#include <math.h>
 #include <wlr/types/wlr_cursor.h>
 #include "sway/desktop.h"
+#include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
 #include "sway/input/seat.h"
+#include "sway/server.h"
 
 struct seatop_move_floating_event {
 	struct sway_container *con;
+
+	// Motion accumulated since the last time the move was applied
+	double pending_dx, pending_dy;
+	struct wl_event_source *idle_source;
 };
 
+static void apply_pending_move(struct seatop_move_floating_event *e) {
+	if (e->pending_dx == 0 && e->pending_dy == 0) {
+		return;
+	}
+	struct sway_container *con = e->con;
+	container_floating_translate(con, e->pending_dx, e->pending_dy);
+	e->pending_dx = e->pending_dy = 0;
+
+	// Damage the union of the old and new boxes once, padded by 1px because
+	// the coordinates are doubles and might be fractions
+	double x1 = fmin(con->current.x, con->x);
+	double y1 = fmin(con->current.y, con->y);
+	double x2 = fmax(con->current.x + con->current.width, con->x + con->width);
+	double y2 = fmax(con->current.y + con->current.height,
+			con->y + con->height);
+	struct wlr_box box = {
+		.x = floor(x1) - 1,
+		.y = floor(y1) - 1,
+		.width = ceil(x2) - floor(x1) + 2,
+		.height = ceil(y2) - floor(y1) + 2,
+	};
+	desktop_damage_box(&box);
+}
+
+static void handle_idle(void *data) {
+	struct seatop_move_floating_event *e = data;
+	e->idle_source = NULL;
+	apply_pending_move(e);
+	transaction_commit_dirty();
+}
+
+static void flush_pending_move(struct seatop_move_floating_event *e) {
+	if (e->idle_source) {
+		wl_event_source_remove(e->idle_source);
+		e->idle_source = NULL;
+	}
+	apply_pending_move(e);
+}
+
 static void handle_button(struct sway_seat *seat, uint32_t time_msec,
 		struct wlr_input_device *device, uint32_t button,
 		enum wlr_button_state state) {
 	if (seat->cursor->pressed_button_count == 0) {
 		struct seatop_move_floating_event *e = seat->seatop_data;
+		flush_pending_move(e);
 
 		// We "move" the container to its own location
 		// so it discovers its output again.
@@ -25,22 +72,39 @@ static void handle_button(struct sway_seat *seat, uint32_t time_msec,
 static void handle_motion(struct sway_seat *seat, uint32_t time_msec,
 		double dx, double dy) {
 	struct seatop_move_floating_event *e = seat->seatop_data;
-	desktop_damage_whole_container(e->con);
-	container_floating_translate(e->con, dx, dy);
-	desktop_damage_whole_container(e->con);
+	e->pending_dx += dx;
+	e->pending_dy += dy;
+
+	// Pointer devices can report several motion events per frame, so the move
+	// is applied once all queued input has been dispatched.
+	if (!e->idle_source) {
+		e->idle_source = wl_event_loop_add_idle(server.wl_event_loop,
+				handle_idle, e);
+		if (!e->idle_source) {
+			apply_pending_move(e);
+		}
+	}
 }
 
 static void handle_unref(struct sway_seat *seat, struct sway_container *con) {
 	struct seatop_move_floating_event *e = seat->seatop_data;
 	if (e->con == con) {
+		// Drop the pending motion rather than moving a destroying container
+		e->pending_dx = e->pending_dy = 0;
 		seatop_begin_default(seat);
 	}
 }
 
+static void handle_end(struct sway_seat *seat) {
+	struct seatop_move_floating_event *e = seat->seatop_data;
+	flush_pending_move(e);
+}
+
 static const struct sway_seatop_impl seatop_impl = {
 	.button = handle_button,
 	.motion = handle_motion,
 	.unref = handle_unref,
+	.end = handle_end,
 };
 
 void seatop_begin_move_floating(struct sway_seat *seat,
@@ -5,6 +5,7 @@
 #include "config.h"
 #include "log.h"
 #include "sway/config.h"
+#include "sway/desktop/memory.h"
 #include "sway/ipc-json.h"
 #include "sway/tree/container.h"
 #include "sway/tree/view.h"
@@ -890,6 +891,55 @@ json_object *ipc_json_describe_seat(struct sway_seat *seat) {
 	}
 	json_object_object_add(object, "devices", devices);
 
+	json_object *rebase_stats = json_object_new_object();
+	json_object_object_add(rebase_stats, "fast_path",
+		json_object_new_int64(seat->cursor->rebase_stats.fast_path));
+	json_object_object_add(rebase_stats, "full",
+		json_object_new_int64(seat->cursor->rebase_stats.full));
+	json_object_object_add(object, "pointer_rebases", rebase_stats);
+
+	return object;
+}
+
+static json_object *describe_memory_categories(size_t *bytes) {
+	json_object *object = json_object_new_object();
+	size_t total = 0;
+	for (int i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		json_object_object_add(object, memory_category_name(i),
+			json_object_new_int64(bytes[i]));
+		total += bytes[i];
+	}
+	json_object_object_add(object, "total", json_object_new_int64(total));
+	return object;
+}
+
+json_object *ipc_json_get_memory(void) {
+	struct sway_memory_usage usage;
+	memory_usage_collect(&usage);
+
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "budget",
+		json_object_new_int64(config->memory_budget));
+	json_object_object_add(object, "usage",
+		describe_memory_categories(usage.bytes));
+
+	json_object *clients = json_object_new_array();
+	for (int i = 0; i < usage.clients->length; ++i) {
+		struct sway_memory_client *client = usage.clients->items[i];
+		json_object *json_client = describe_memory_categories(client->bytes);
+		json_object_object_add(json_client, "pid",
+			json_object_new_int(client->pid));
+		json_object_array_add(clients, json_client);
+	}
+	json_object_object_add(object, "clients", clients);
+
+	const struct sway_memory_evictions *evictions = memory_get_evictions();
+	json_object *json_evictions = json_object_new_object();
+	json_object_object_add(json_evictions, "title_textures",
+		json_object_new_int64(evictions->title_textures));
+	json_object_object_add(object, "evictions", json_evictions);
+
+	memory_usage_finish(&usage);
 	return object;
 }
 
@@ -17,11 +17,13 @@
 #include <wayland-server.h>
 #include "sway/commands.h"
 #include "sway/config.h"
+#include "sway/criteria.h"
 #include "sway/desktop/transaction.h"
 #include "sway/ipc-json.h"
 #include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/server.h"
+#include "sway/trace.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/keyboard.h"
 #include "sway/input/seat.h"
@@ -49,6 +51,8 @@ struct ipc_client {
 	int fd;
 	uint32_t security_policy;
 	enum ipc_command_type subscribed_events;
+	enum ipc_command_type unfiltered_events;
+	list_t *event_filters; // struct ipc_event_filter
 	size_t write_buffer_len;
 	size_t write_buffer_size;
 	char *write_buffer;
@@ -57,6 +61,30 @@ struct ipc_client {
 	enum ipc_command_type pending_type;
 };
 
+/**
+ * Restricts a subscription to events with the given change, and for window
+ * events, to containers matching the criteria.
+ */
+struct ipc_event_filter {
+	enum ipc_command_type event;
+	char *change; // NULL matches any change
+	struct criteria *criteria; // NULL matches any container
+};
+
+static const struct {
+	const char *name;
+	enum ipc_command_type event;
+} ipc_event_names[] = {
+	{ "workspace", IPC_EVENT_WORKSPACE },
+	{ "mode", IPC_EVENT_MODE },
+	{ "window", IPC_EVENT_WINDOW },
+	{ "barconfig_update", IPC_EVENT_BARCONFIG_UPDATE },
+	{ "binding", IPC_EVENT_BINDING },
+	{ "shutdown", IPC_EVENT_SHUTDOWN },
+	{ "tick", IPC_EVENT_TICK },
+	{ "bar_state_update", IPC_EVENT_BAR_STATE_UPDATE },
+};
+
 struct sockaddr_un *ipc_user_sockaddr(void);
 int ipc_handle_connection(int fd, uint32_t mask, void *data);
 int ipc_client_handle_readable(int client_fd, uint32_t mask, void *data);
@@ -184,6 +212,8 @@ int ipc_handle_connection(int fd, uint32_t mask, void *data) {
 	client->pending_length = 0;
 	client->fd = client_fd;
 	client->subscribed_events = 0;
+	client->unfiltered_events = 0;
+	client->event_filters = create_list();
 	client->event_source = wl_event_loop_add_fd(server->wl_event_loop,
 			client_fd, WL_EVENT_READABLE, ipc_client_handle_readable, client);
 	client->writable_event_source = NULL;
@@ -272,21 +302,62 @@ int ipc_client_handle_readable(int client_fd, uint32_t mask, void *data) {
 	return 0;
 }
 
-static bool ipc_has_event_listeners(enum ipc_command_type event) {
+static void ipc_event_filter_destroy(struct ipc_event_filter *filter) {
+	free(filter->change);
+	if (filter->criteria) {
+		criteria_destroy(filter->criteria);
+	}
+	free(filter);
+}
+
+static bool ipc_client_wants_event(struct ipc_client *client,
+		enum ipc_command_type event, const char *change,
+		struct sway_container *con) {
+	if ((client->subscribed_events & event_mask(event)) == 0) {
+		return false;
+	}
+	if ((client->unfiltered_events & event_mask(event)) != 0) {
+		return true;
+	}
+	for (int i = 0; i < client->event_filters->length; ++i) {
+		struct ipc_event_filter *filter = client->event_filters->items[i];
+		if (filter->event != event) {
+			continue;
+		}
+		if (filter->change && (!change || strcmp(filter->change, change) != 0)) {
+			continue;
+		}
+		if (filter->criteria && (!con || !con->view ||
+					!criteria_matches_view(filter->criteria, con->view))) {
+			continue;
+		}
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Checks whether any client wants the event, so it isn't serialized for
+ * nobody. The change and container are only used by filtered subscriptions
+ * and may be NULL.
+ */
+static bool ipc_has_event_listeners(enum ipc_command_type event,
+		const char *change, struct sway_container *con) {
 	for (int i = 0; i < ipc_client_list->length; i++) {
 		struct ipc_client *client = ipc_client_list->items[i];
-		if ((client->subscribed_events & event_mask(event)) != 0) {
+		if (ipc_client_wants_event(client, event, change, con)) {
 			return true;
 		}
 	}
 	return false;
 }
 
-static void ipc_send_event(const char *json_string, enum ipc_command_type event) {
+static void ipc_send_event(const char *json_string, enum ipc_command_type event,
+		const char *change, struct sway_container *con) {
 	struct ipc_client *client;
 	for (int i = 0; i < ipc_client_list->length; i++) {
 		client = ipc_client_list->items[i];
-		if ((client->subscribed_events & event_mask(event)) == 0) {
+		if (!ipc_client_wants_event(client, event, change, con)) {
 			continue;
 		}
 		if (!ipc_send_reply(client, event, json_string,
@@ -302,7 +373,7 @@ static void ipc_send_event(const char *json_string, enum ipc_command_type event)
 
 void ipc_event_workspace(struct sway_workspace *old,
 		struct sway_workspace *new, const char *change) {
-	if (!ipc_has_event_listeners(IPC_EVENT_WORKSPACE)) {
+	if (!ipc_has_event_listeners(IPC_EVENT_WORKSPACE, change, NULL)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending workspace::%s event", change);
@@ -323,12 +394,12 @@ void ipc_event_workspace(struct sway_workspace *old,
 	}
 
 	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_WORKSPACE);
+	ipc_send_event(json_string, IPC_EVENT_WORKSPACE, change, NULL);
 	json_object_put(obj);
 }
 
 void ipc_event_window(struct sway_container *window, const char *change) {
-	if (!ipc_has_event_listeners(IPC_EVENT_WINDOW)) {
+	if (!ipc_has_event_listeners(IPC_EVENT_WINDOW, change, window)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending window::%s event", change);
@@ -338,24 +409,24 @@ void ipc_event_window(struct sway_container *window, const char *change) {
 			ipc_json_describe_node_recursive(&window->node));
 
 	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_WINDOW);
+	ipc_send_event(json_string, IPC_EVENT_WINDOW, change, window);
 	json_object_put(obj);
 }
 
 void ipc_event_barconfig_update(struct bar_config *bar) {
-	if (!ipc_has_event_listeners(IPC_EVENT_BARCONFIG_UPDATE)) {
+	if (!ipc_has_event_listeners(IPC_EVENT_BARCONFIG_UPDATE, NULL, NULL)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending barconfig_update event");
 	json_object *json = ipc_json_describe_bar_config(bar);
 
 	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_BARCONFIG_UPDATE);
+	ipc_send_event(json_string, IPC_EVENT_BARCONFIG_UPDATE, NULL, NULL);
 	json_object_put(json);
 }
 
 void ipc_event_bar_state_update(struct bar_config *bar) {
-	if (!ipc_has_event_listeners(IPC_EVENT_BAR_STATE_UPDATE)) {
+	if (!ipc_has_event_listeners(IPC_EVENT_BAR_STATE_UPDATE, NULL, NULL)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending bar_state_update event");
@@ -366,12 +437,12 @@ void ipc_event_bar_state_update(struct bar_config *bar) {
 			json_object_new_boolean(bar->visible_by_modifier));
 
 	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_BAR_STATE_UPDATE);
+	ipc_send_event(json_string, IPC_EVENT_BAR_STATE_UPDATE, NULL, NULL);
 	json_object_put(json);
 }
 
 void ipc_event_mode(const char *mode, bool pango) {
-	if (!ipc_has_event_listeners(IPC_EVENT_MODE)) {
+	if (!ipc_has_event_listeners(IPC_EVENT_MODE, mode, NULL)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending mode::%s event", mode);
@@ -381,12 +452,12 @@ void ipc_event_mode(const char *mode, bool pango) {
 			json_object_new_boolean(pango));
 
 	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_MODE);
+	ipc_send_event(json_string, IPC_EVENT_MODE, mode, NULL);
 	json_object_put(obj);
 }
 
 void ipc_event_shutdown(const char *reason) {
-	if (!ipc_has_event_listeners(IPC_EVENT_SHUTDOWN)) {
+	if (!ipc_has_event_listeners(IPC_EVENT_SHUTDOWN, reason, NULL)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending shutdown::%s event", reason);
@@ -395,12 +466,12 @@ void ipc_event_shutdown(const char *reason) {
 	json_object_object_add(json, "change", json_object_new_string(reason));
 
 	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_SHUTDOWN);
+	ipc_send_event(json_string, IPC_EVENT_SHUTDOWN, reason, NULL);
 	json_object_put(json);
 }
 
 void ipc_event_binding(struct sway_binding *binding) {
-	if (!ipc_has_event_listeners(IPC_EVENT_BINDING)) {
+	if (!ipc_has_event_listeners(IPC_EVENT_BINDING, "run", NULL)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending binding event");
@@ -468,12 +539,12 @@ void ipc_event_binding(struct sway_binding *binding) {
 	json_object_object_add(json, "change", json_object_new_string("run"));
 	json_object_object_add(json, "binding", json_binding);
 	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_BINDING);
+	ipc_send_event(json_string, IPC_EVENT_BINDING, "run", NULL);
 	json_object_put(json);
 }
 
 static void ipc_event_tick(const char *payload) {
-	if (!ipc_has_event_listeners(IPC_EVENT_TICK)) {
+	if (!ipc_has_event_listeners(IPC_EVENT_TICK, NULL, NULL)) {
 		return;
 	}
 	sway_log(SWAY_DEBUG, "Sending tick event");
@@ -483,7 +554,7 @@ static void ipc_event_tick(const char *payload) {
 	json_object_object_add(json, "payload", json_object_new_string(payload));
 
 	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_TICK);
+	ipc_send_event(json_string, IPC_EVENT_TICK, NULL, NULL);
 	json_object_put(json);
 }
 
@@ -546,6 +617,10 @@ void ipc_client_disconnect(struct ipc_client *client) {
 		i++;
 	}
 	list_del(ipc_client_list, i);
+	for (int i = 0; i < client->event_filters->length; ++i) {
+		ipc_event_filter_destroy(client->event_filters->items[i]);
+	}
+	list_free(client->event_filters);
 	free(client->write_buffer);
 	close(client->fd);
 	free(client);
@@ -578,6 +653,84 @@ static void ipc_get_marks_callback(struct sway_container *con, void *data) {
 	}
 }
 
+static bool ipc_event_from_name(const char *name, size_t len,
+		enum ipc_command_type *event) {
+	for (size_t i = 0; i < sizeof(ipc_event_names) / sizeof(ipc_event_names[0]);
+			++i) {
+		if (strlen(ipc_event_names[i].name) == len &&
+				strncmp(ipc_event_names[i].name, name, len) == 0) {
+			*event = ipc_event_names[i].event;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Adds one item of a subscribe request: either a string naming the event type,
+ * optionally followed by ::change, or an object with a type and an optional
+ * change and criteria.
+ */
+static bool ipc_client_subscribe(struct ipc_client *client, json_object *item,
+		enum ipc_command_type *event) {
+	const char *type = NULL, *change = NULL, *criteria = NULL;
+	size_t type_len = 0;
+	if (json_object_is_type(item, json_type_string)) {
+		type = json_object_get_string(item);
+		const char *sep = strstr(type, "::");
+		type_len = sep ? (size_t)(sep - type) : strlen(type);
+		change = sep ? sep + 2 : NULL;
+	} else if (json_object_is_type(item, json_type_object)) {
+		json_object *value;
+		if (json_object_object_get_ex(item, "type", &value)) {
+			type = json_object_get_string(value);
+			type_len = type ? strlen(type) : 0;
+		}
+		if (json_object_object_get_ex(item, "change", &value)) {
+			change = json_object_get_string(value);
+		}
+		if (json_object_object_get_ex(item, "criteria", &value)) {
+			criteria = json_object_get_string(value);
+		}
+	}
+
+	if (!type || !ipc_event_from_name(type, type_len, event)) {
+		return false;
+	}
+	// Only window events are about a single container
+	if (criteria && *event != IPC_EVENT_WINDOW) {
+		return false;
+	}
+	client->subscribed_events |= event_mask(*event);
+	if (!change && !criteria) {
+		client->unfiltered_events |= event_mask(*event);
+		return true;
+	}
+
+	struct ipc_event_filter *filter = calloc(1, sizeof(struct ipc_event_filter));
+	if (!filter) {
+		sway_log(SWAY_ERROR, "Unable to allocate event filter");
+		return false;
+	}
+	filter->event = *event;
+	filter->change = change ? strdup(change) : NULL;
+	if (criteria) {
+		char *raw = strdup(criteria);
+		char *error = NULL;
+		filter->criteria = criteria_parse(raw, &error);
+		free(raw);
+		if (!filter->criteria) {
+			sway_log(SWAY_INFO, "Invalid criteria in subscribe request: %s",
+					error);
+			free(error);
+			ipc_event_filter_destroy(filter);
+			return false;
+		}
+	}
+	list_add(client->event_filters, filter);
+	return true;
+}
+
 void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_length,
 		enum ipc_command_type payload_type) {
 	if (!sway_assert(client != NULL, "client != NULL")) {
@@ -603,6 +756,9 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	}
 	buf[payload_length] = '\0';
 
+	// The client may be disconnected while handling the message
+	int client_fd = client->fd;
+	trace_record(TRACE_IPC, TRACE_BEGIN, client_fd, payload_type);
 	switch (payload_type) {
 	case IPC_COMMAND:
 	{
@@ -698,31 +854,18 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 		bool is_tick = false;
 		// parse requested event types
 		for (size_t i = 0; i < json_object_array_length(request); i++) {
-			const char *event_type = json_object_get_string(json_object_array_get_idx(request, i));
-			if (strcmp(event_type, "workspace") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_WORKSPACE);
-			} else if (strcmp(event_type, "barconfig_update") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_BARCONFIG_UPDATE);
-			} else if (strcmp(event_type, "bar_state_update") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_BAR_STATE_UPDATE);
-			} else if (strcmp(event_type, "mode") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_MODE);
-			} else if (strcmp(event_type, "shutdown") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_SHUTDOWN);
-			} else if (strcmp(event_type, "window") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_WINDOW);
-			} else if (strcmp(event_type, "binding") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_BINDING);
-			} else if (strcmp(event_type, "tick") == 0) {
-				client->subscribed_events |= event_mask(IPC_EVENT_TICK);
-				is_tick = true;
-			} else {
+			json_object *item = json_object_array_get_idx(request, i);
+			enum ipc_command_type event;
+			if (!ipc_client_subscribe(client, item, &event)) {
 				const char msg[] = "{\"success\": false}";
 				ipc_send_reply(client, payload_type, msg, strlen(msg));
 				json_object_put(request);
 				sway_log(SWAY_INFO, "Unsupported event type in subscribe request");
 				goto exit_cleanup;
 			}
+			if (event == IPC_EVENT_TICK) {
+				is_tick = true;
+			}
 		}
 
 		json_object_put(request);
@@ -764,6 +907,42 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 		goto exit_cleanup;
 	}
 
+	case IPC_GET_MEMORY:
+	{
+		json_object *memory = ipc_json_get_memory();
+		const char *json_string = json_object_to_json_string(memory);
+		ipc_send_reply(client, payload_type, json_string,
+			(uint32_t)strlen(json_string));
+		json_object_put(memory); // free
+		goto exit_cleanup;
+	}
+
+	case IPC_DUMP_TRACE:
+	{
+		// The payload is ignored: clients don't get to choose which file
+		// the compositor writes to
+		size_t records = 0;
+		char *path = trace_dump(&records);
+		json_object *reply = json_object_new_object();
+		json_object_object_add(reply, "success",
+				json_object_new_boolean(path != NULL));
+		if (path) {
+			json_object_object_add(reply, "path",
+					json_object_new_string(path));
+			json_object_object_add(reply, "records",
+					json_object_new_int64(records));
+		} else {
+			json_object_object_add(reply, "error",
+					json_object_new_string("Unable to write trace"));
+		}
+		const char *json_string = json_object_to_json_string(reply);
+		ipc_send_reply(client, payload_type, json_string,
+			(uint32_t)strlen(json_string));
+		json_object_put(reply); // free
+		free(path);
+		goto exit_cleanup;
+	}
+
 	case IPC_GET_TREE:
 	{
 		json_object *tree = ipc_json_describe_node_recursive(&root->node);
@@ -872,6 +1051,7 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	}
 
 exit_cleanup:
+	trace_record(TRACE_IPC, TRACE_END, client_fd, payload_type);
 	free(buf);
 	return;
 }
@@ -917,7 +1097,7 @@ bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_typ
 				ipc_client_handle_writable, client);
 	}
 
-	sway_log(SWAY_DEBUG, "Added IPC reply of type 0x%x to client %d queue: %s",
-		payload_type, client->fd, payload);
+	sway_log(SWAY_DEBUG, "Added IPC reply of type 0x%x to client %d queue "
+		"(%u bytes)", payload_type, client->fd, payload_length);
 	return true;
 }
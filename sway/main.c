@@ -12,6 +12,7 @@
 #include <sys/un.h>
 #include <unistd.h>
 #include <wlr/util/log.h>
+#include "sway/benchmark.h"
 #include "sway/commands.h"
 #include "sway/config.h"
 #include "sway/server.h"
@@ -198,6 +199,23 @@ static bool drop_permissions(void) {
 	return true;
 }
 
+static void handle_wlr_log(enum wlr_log_importance importance,
+		const char *fmt, va_list args) {
+	// wlroots' importances match ours
+	_sway_vlog((sway_log_importance_t)importance, fmt, args);
+}
+
+static wlr_log_func_t init_async_log(void) {
+	if (!debug.log_async) {
+		return NULL;
+	}
+	if (!sway_log_init_async()) {
+		fprintf(stderr, "Unable to start the log writer thread\n");
+		return NULL;
+	}
+	return handle_wlr_log;
+}
+
 void enable_debug_flag(const char *flag) {
 	if (strcmp(flag, "damage=highlight") == 0) {
 		debug.damage = DAMAGE_HIGHLIGHT;
@@ -207,10 +225,18 @@ void enable_debug_flag(const char *flag) {
 		debug.noatomic = true;
 	} else if (strcmp(flag, "txn-wait") == 0) {
 		debug.txn_wait = true;
+	} else if (strcmp(flag, "xwayland-nowait") == 0) {
+		debug.xwayland_nowait = true;
 	} else if (strcmp(flag, "txn-timings") == 0) {
 		debug.txn_timings = true;
+	} else if (strcmp(flag, "log-async") == 0) {
+		debug.log_async = true;
 	} else if (strncmp(flag, "txn-timeout=", 12) == 0) {
 		server.txn_timeout_ms = atoi(&flag[12]);
+	} else if (strcmp(flag, "notrace") == 0) {
+		debug.notrace = true;
+	} else if (strncmp(flag, "trace-records=", 14) == 0) {
+		server.trace_records = atoi(&flag[14]);
 	}
 }
 
@@ -227,10 +253,12 @@ int main(int argc, char **argv) {
 		{"get-socketpath", no_argument, NULL, 'p'},
 		{"unsupported-gpu", no_argument, NULL, 'u'},
 		{"my-next-gpu-wont-be-nvidia", no_argument, NULL, 'u'},
+		{"benchmark", required_argument, NULL, 'b'},
 		{0, 0, 0, 0}
 	};
 
 	char *config_path = NULL;
+	char *benchmark_path = NULL;
 
 	const char* usage =
 		"Usage: sway [options] [command]\n"
@@ -242,6 +270,7 @@ int main(int argc, char **argv) {
 		"  -v, --version          Show the version number and quit.\n"
 		"  -V, --verbose          Enables more verbose logging.\n"
 		"      --get-socketpath   Gets the IPC socket path and prints it, then exits.\n"
+		"      --benchmark <file> Runs a benchmark scenario headless, then exits.\n"
 		"\n";
 
 	int c;
@@ -271,6 +300,9 @@ int main(int argc, char **argv) {
 		case 'u':
 			allow_unsupported_gpu = 1;
 			break;
+		case 'b': // benchmark
+			benchmark_path = strdup(optarg);
+			break;
 		case 'v': // version
 			fprintf(stdout, "sway version " SWAY_VERSION "\n");
 			exit(EXIT_SUCCESS);
@@ -302,16 +334,17 @@ int main(int argc, char **argv) {
 	}
 
 	// As the 'callback' function for wlr_log is equivalent to that for
-	// sway, we do not need to override it.
+	// sway, we do not need to override it unless logging asynchronously.
+	wlr_log_func_t wlr_log_callback = init_async_log();
 	if (debug) {
 		sway_log_init(SWAY_DEBUG, sway_terminate);
-		wlr_log_init(WLR_DEBUG, NULL);
+		wlr_log_init(WLR_DEBUG, wlr_log_callback);
 	} else if (verbose || validate) {
 		sway_log_init(SWAY_INFO, sway_terminate);
-		wlr_log_init(WLR_INFO, NULL);
+		wlr_log_init(WLR_INFO, wlr_log_callback);
 	} else {
 		sway_log_init(SWAY_ERROR, sway_terminate);
-		wlr_log_init(WLR_ERROR, NULL);
+		wlr_log_init(WLR_ERROR, wlr_log_callback);
 	}
 
 	log_kernel();
@@ -345,6 +378,10 @@ int main(int argc, char **argv) {
 		return 0;
 	}
 
+	if (benchmark_path && !benchmark_init(benchmark_path)) {
+		exit(EXIT_FAILURE);
+	}
+
 	if (!server_privileged_prepare(&server)) {
 		return 1;
 	}
@@ -397,11 +434,21 @@ int main(int argc, char **argv) {
 		swaynag_show(&config->swaynag_config_errors);
 	}
 
+	if (benchmark_path) {
+		benchmark_start();
+	}
+
 	server_run(&server);
 
 shutdown:
 	sway_log(SWAY_INFO, "Shutting down sway");
 
+	if (benchmark_path) {
+		// The scenario's event sources belong to the display's event loop
+		benchmark_finish();
+		free(benchmark_path);
+	}
+
 	server_fini(&server);
 	root_destroy(root);
 	root = NULL;
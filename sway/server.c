@@ -30,6 +30,7 @@
 #include "sway/input/input-manager.h"
 #include "sway/output.h"
 #include "sway/server.h"
+#include "sway/trace.h"
 #include "sway/tree/root.h"
 #if HAVE_XWAYLAND
 #include "sway/xwayland.h"
@@ -147,6 +148,14 @@ bool server_init(struct sway_server *server) {
 		server->txn_timeout_ms = 200;
 	}
 
+	// This may have been set already via -Dtrace-records
+	if (!server->trace_records) {
+		server->trace_records = 1 << 16;
+	}
+	if (!debug.notrace) {
+		trace_init(server->trace_records);
+	}
+
 	server->dirty_nodes = create_list();
 	server->transactions = create_list();
 
@@ -162,6 +171,7 @@ void server_fini(struct sway_server *server) {
 	wlr_xwayland_destroy(server->xwayland.wlr_xwayland);
 #endif
 	wl_display_destroy_clients(server->wl_display);
+	trace_finish();
 	wl_display_destroy(server->wl_display);
 	list_free(server->dirty_nodes);
 	list_free(server->transactions);
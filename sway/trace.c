@@ -0,0 +1,198 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-server.h>
+#include "sway/server.h"
+#include "sway/trace.h"
+#include "log.h"
+
+#define TRACE_MAX_NAMES 1024
+
+static const char trace_magic[8] = {'S', 'W', 'A', 'Y', 'T', 'R', 'C', '1'};
+
+static struct {
+	struct sway_trace_record *records;
+	size_t capacity;
+	uint64_t written; // total, including those overwritten since
+
+	const char *names[TRACE_MAX_NAMES];
+	uint16_t name_count;
+
+	struct wl_event_source *signal_source;
+} trace;
+
+static uint16_t intern_name(const char *name) {
+	if (!name) {
+		return 0;
+	}
+	// Names are static strings, so only the address needs comparing
+	for (uint16_t i = 1; i < trace.name_count; ++i) {
+		if (trace.names[i] == name) {
+			return i;
+		}
+	}
+	if (trace.name_count == TRACE_MAX_NAMES) {
+		return 0;
+	}
+	trace.names[trace.name_count] = name;
+	return trace.name_count++;
+}
+
+void trace_record_named(enum sway_trace_event event,
+		enum sway_trace_phase phase, const char *name, uint32_t id,
+		uint64_t arg) {
+	if (!trace.records) {
+		return;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	struct sway_trace_record *record =
+		&trace.records[trace.written++ % trace.capacity];
+	record->time = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+	record->arg = arg;
+	record->id = id;
+	record->event = event;
+	record->phase = phase;
+	record->name = intern_name(name);
+}
+
+void trace_record(enum sway_trace_event event, enum sway_trace_phase phase,
+		uint32_t id, uint64_t arg) {
+	trace_record_named(event, phase, NULL, id, arg);
+}
+
+/**
+ * Create a new dump file, never reusing an existing one. Returns the open file
+ * and stores its path in dump_path, which the caller must free.
+ */
+static FILE *create_dump_file(char **dump_path) {
+	static unsigned int sequence = 0;
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+	if (!dir) {
+		dir = "/tmp";
+	}
+	long now = time(NULL);
+	int fd = -1;
+	char *path = NULL;
+	// Dumps made within the same second get the next sequence number
+	for (int attempt = 0; fd == -1 && attempt < 16; ++attempt) {
+		free(path);
+		unsigned int seq = sequence++;
+		size_t len = snprintf(NULL, 0, "%s/sway-trace.%d.%ld.%u.bin",
+				dir, getpid(), now, seq) + 1;
+		path = malloc(len);
+		if (!path) {
+			sway_log(SWAY_ERROR, "Unable to allocate trace path");
+			return NULL;
+		}
+		snprintf(path, len, "%s/sway-trace.%d.%ld.%u.bin",
+				dir, getpid(), now, seq);
+		fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+		if (fd == -1 && errno != EEXIST) {
+			break;
+		}
+	}
+	if (fd == -1) {
+		sway_log_errno(SWAY_ERROR, "Unable to create %s", path);
+		free(path);
+		return NULL;
+	}
+	FILE *f = fdopen(fd, "w");
+	if (!f) {
+		sway_log_errno(SWAY_ERROR, "Unable to open %s", path);
+		close(fd);
+		free(path);
+		return NULL;
+	}
+	*dump_path = path;
+	return f;
+}
+
+char *trace_dump(size_t *record_count) {
+	if (!trace.records) {
+		sway_log(SWAY_ERROR, "Tracing is disabled");
+		return NULL;
+	}
+	char *dump_path = NULL;
+	FILE *f = create_dump_file(&dump_path);
+	if (!f) {
+		return NULL;
+	}
+
+	uint64_t count = trace.written < trace.capacity ?
+		trace.written : trace.capacity;
+	uint64_t overwritten = trace.written - count;
+	uint32_t record_size = sizeof(struct sway_trace_record);
+	uint32_t name_count = trace.name_count;
+	fwrite(trace_magic, 1, sizeof(trace_magic), f);
+	fwrite(&record_size, sizeof(record_size), 1, f);
+	fwrite(&name_count, sizeof(name_count), 1, f);
+	fwrite(&count, sizeof(count), 1, f);
+	fwrite(&overwritten, sizeof(overwritten), 1, f);
+	for (uint32_t i = 0; i < name_count; ++i) {
+		const char *name = trace.names[i] ? trace.names[i] : "";
+		uint16_t len = strlen(name);
+		fwrite(&len, sizeof(len), 1, f);
+		fwrite(name, 1, len, f);
+	}
+
+	// Oldest first: from the write position to the end, then the start
+	size_t start = overwritten ? trace.written % trace.capacity : 0;
+	fwrite(&trace.records[start], record_size, count - start, f);
+	fwrite(trace.records, record_size, start, f);
+
+	bool failed = ferror(f);
+	if (fclose(f) != 0 || failed) {
+		sway_log_errno(SWAY_ERROR, "Unable to write trace to %s", dump_path);
+		free(dump_path);
+		return NULL;
+	}
+	sway_log(SWAY_INFO, "Wrote %" PRIu64 " trace records to %s",
+			count, dump_path);
+	if (record_count) {
+		*record_count = count;
+	}
+	return dump_path;
+}
+
+static int handle_signal(int signal, void *data) {
+	free(trace_dump(NULL));
+	return 0;
+}
+
+bool trace_init(size_t capacity) {
+	trace.records = calloc(capacity, sizeof(struct sway_trace_record));
+	if (!trace.records) {
+		sway_log(SWAY_ERROR, "Unable to allocate trace records");
+		return false;
+	}
+	trace.capacity = capacity;
+	trace.written = 0;
+	trace.names[0] = NULL;
+	trace.name_count = 1;
+
+	trace.signal_source = wl_event_loop_add_signal(server.wl_event_loop,
+			SIGUSR2, handle_signal, NULL);
+	if (!trace.signal_source) {
+		sway_log(SWAY_ERROR, "Unable to listen for SIGUSR2, "
+				"traces can only be written over IPC");
+	}
+	return true;
+}
+
+void trace_finish(void) {
+	if (trace.signal_source) {
+		wl_event_source_remove(trace.signal_source);
+		trace.signal_source = NULL;
+	}
+	free(trace.records);
+	trace.records = NULL;
+}
@@ -12,6 +12,7 @@
 #include "pango.h"
 #include "sway/config.h"
 #include "sway/desktop.h"
+#include "sway/desktop/memory.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
@@ -521,6 +522,7 @@ void container_update_title_textures(struct sway_container *container) {
 	update_title_texture(container, &container->title_urgent,
 			&config->border_colors.urgent);
 	container_damage_whole(container);
+	memory_budget_schedule_check();
 }
 
 void container_calculate_title_height(struct sway_container *container) {
@@ -1585,6 +1587,7 @@ void container_update_marks_textures(struct sway_container *con) {
 	update_marks_texture(con, &con->marks_urgent,
 			&config->border_colors.urgent);
 	container_damage_whole(con);
+	memory_budget_schedule_check();
 }
 
 void container_raise_floating(struct sway_container *con) {
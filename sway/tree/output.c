@@ -154,7 +154,9 @@ void output_enable(struct sway_output *output, struct output_config *oc) {
 	wl_signal_emit(&root->events.new_node, &output->node);
 
 	arrange_layers(output);
-	arrange_root();
+	if (!output_config_batch_defer_arrange()) {
+		arrange_root();
+	}
 }
 
 static void evacuate_sticky(struct sway_workspace *old_ws,
@@ -267,8 +269,11 @@ void output_disable(struct sway_output *output) {
 
 	output->enabled = false;
 	output->configured = false;
+	output->batch_needs_arrange = output->batch_needs_textures = false;
 
-	arrange_root();
+	if (!output_config_batch_defer_arrange()) {
+		arrange_root();
+	}
 }
 
 void output_begin_destroy(struct sway_output *output) {
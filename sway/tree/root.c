@@ -19,6 +19,11 @@ struct sway_root *root;
 
 static void output_layout_handle_change(struct wl_listener *listener,
 		void *data) {
+	// Outputs are added to the layout one by one while a configuration batch
+	// is applied, which arranges once at the end instead
+	if (output_config_batch_defer_arrange()) {
+		return;
+	}
 	arrange_root();
 	transaction_commit_dirty();
 }
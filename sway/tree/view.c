@@ -1,5 +1,7 @@
 #define _POSIX_C_SOURCE 200809L
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <wayland-server.h>
 #include <wlr/render/wlr_renderer.h>
@@ -37,6 +39,7 @@ void view_init(struct sway_view *view, enum sway_view_type type,
 	view->executed_criteria = create_list();
 	view->allow_request_urgent = true;
 	wl_signal_init(&view->events.unmap);
+	wl_list_init(&view->children);
 }
 
 void view_destroy(struct sway_view *view) {
@@ -381,10 +384,69 @@ void view_close_popups(struct sway_view *view) {
 	}
 }
 
+static bool box_contains(const struct wlr_box *outer,
+		const struct wlr_box *inner) {
+	return inner->x >= outer->x && inner->y >= outer->y &&
+		inner->x + inner->width <= outer->x + outer->width &&
+		inner->y + inner->height <= outer->y + outer->height;
+}
+
+static void view_child_update_box(struct sway_view_child *child);
+
 void view_damage_from(struct sway_view *view) {
+	if (!view_is_visible(view)) {
+		return;
+	}
+	struct sway_container *con = view->container;
+
+	// Subsurface positions are applied by the parent's commit, so they have
+	// to be looked at here. Most views have no children at all.
+	struct sway_view_child *child;
+	wl_list_for_each(child, &view->children, view_link) {
+		view_child_update_box(child);
+	}
+
+	struct wlr_box con_box = {
+		.x = con->current.x,
+		.y = con->current.y,
+		.width = con->current.width,
+		.height = con->current.height,
+	};
+	struct wlr_box surface_box = {
+		.x = con->surface_x - view->geometry.x,
+		.y = con->surface_y - view->geometry.y,
+		.width = view->surface->current.width,
+		.height = view->surface->current.height,
+	};
+	struct wlr_box children_box = {
+		.x = con->content_x + view->child_extents.x,
+		.y = con->content_y + view->child_extents.y,
+		.width = view->child_extents.width,
+		.height = view->child_extents.height,
+	};
+	bool has_children = children_box.width > 0 && children_box.height > 0;
+
+	if (box_contains(&con_box, &surface_box) &&
+			(!has_children || box_contains(&con_box, &children_box))) {
+		// Only the outputs the container was last found to intersect can
+		// show it
+		for (int i = 0; i < con->outputs->length; ++i) {
+			output_damage_from_view(con->outputs->items[i], view);
+		}
+		return;
+	}
+
+	// Popups and subsurfaces may extend past the container, onto outputs it
+	// doesn't intersect
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
-		output_damage_from_view(output, view);
+		struct wlr_box output_box, intersection;
+		output_get_box(output, &output_box);
+		if (wlr_box_intersection(&intersection, &output_box, &surface_box) ||
+				(has_children && wlr_box_intersection(&intersection,
+					&output_box, &children_box))) {
+			output_damage_from_view(output, view);
+		}
 	}
 }
 
@@ -788,6 +850,7 @@ static void view_subsurface_create(struct sway_view *view,
 	subsurface->destroy.notify = subsurface_handle_destroy;
 
 	subsurface->child.mapped = true;
+	view_child_update_box(&subsurface->child);
 
 	view_child_damage(&subsurface->child, true);
 }
@@ -809,10 +872,54 @@ static void view_child_subsurface_create(struct sway_view_child *child,
 	subsurface->destroy.notify = subsurface_handle_destroy;
 
 	subsurface->child.mapped = true;
+	view_child_update_box(&subsurface->child);
 
 	view_child_damage(&subsurface->child, true);
 }
 
+static void view_update_child_extents(struct sway_view *view) {
+	int x1 = INT_MAX, y1 = INT_MAX, x2 = INT_MIN, y2 = INT_MIN;
+	struct sway_view_child *child;
+	wl_list_for_each(child, &view->children, view_link) {
+		if (child->box.width <= 0 || child->box.height <= 0) {
+			continue;
+		}
+		x1 = child->box.x < x1 ? child->box.x : x1;
+		y1 = child->box.y < y1 ? child->box.y : y1;
+		x2 = child->box.x + child->box.width > x2 ?
+			child->box.x + child->box.width : x2;
+		y2 = child->box.y + child->box.height > y2 ?
+			child->box.y + child->box.height : y2;
+	}
+	if (x1 > x2) {
+		memset(&view->child_extents, 0, sizeof(struct wlr_box));
+		return;
+	}
+	view->child_extents.x = x1;
+	view->child_extents.y = y1;
+	view->child_extents.width = x2 - x1;
+	view->child_extents.height = y2 - y1;
+}
+
+/**
+ * Refresh the box covered by the child, and the view's extents if it changed.
+ */
+static void view_child_update_box(struct sway_view_child *child) {
+	struct wlr_box box = {0};
+	if (child->mapped && child->view && child->view->surface) {
+		child->impl->get_root_coords(child, &box.x, &box.y);
+		box.width = child->surface->current.width;
+		box.height = child->surface->current.height;
+	}
+	if (memcmp(&box, &child->box, sizeof(struct wlr_box)) == 0) {
+		return;
+	}
+	child->box = box;
+	if (child->view) {
+		view_update_child_extents(child->view);
+	}
+}
+
 static void view_child_damage(struct sway_view_child *child, bool whole) {
 	if (!child || !child->mapped || !child->view || !child->view->container) {
 		return;
@@ -828,6 +935,7 @@ static void view_child_handle_surface_commit(struct wl_listener *listener,
 		void *data) {
 	struct sway_view_child *child =
 		wl_container_of(listener, child, surface_commit);
+	view_child_update_box(child);
 	view_child_damage(child, false);
 }
 
@@ -859,6 +967,7 @@ static void view_child_handle_surface_map(struct wl_listener *listener,
 	struct sway_view_child *child =
 		wl_container_of(listener, child, surface_map);
 	child->mapped = true;
+	view_child_update_box(child);
 	view_child_damage(child, true);
 }
 
@@ -868,6 +977,7 @@ static void view_child_handle_surface_unmap(struct wl_listener *listener,
 		wl_container_of(listener, child, surface_unmap);
 	view_child_damage(child, true);
 	child->mapped = false;
+	view_child_update_box(child);
 }
 
 static void view_child_handle_view_unmap(struct wl_listener *listener,
@@ -876,6 +986,7 @@ static void view_child_handle_view_unmap(struct wl_listener *listener,
 		wl_container_of(listener, child, view_unmap);
 	view_child_damage(child, true);
 	child->mapped = false;
+	view_child_update_box(child);
 }
 
 void view_child_init(struct sway_view_child *child,
@@ -885,6 +996,7 @@ void view_child_init(struct sway_view_child *child,
 	child->view = view;
 	child->surface = surface;
 	wl_list_init(&child->children);
+	wl_list_insert(&view->children, &child->view_link);
 
 	wl_signal_add(&surface->events.commit, &child->surface_commit);
 	child->surface_commit.notify = view_child_handle_surface_commit;
@@ -924,6 +1036,11 @@ void view_child_destroy(struct sway_view_child *child) {
 		subchild->parent = NULL;
 	}
 
+	wl_list_remove(&child->view_link);
+	if (child->box.width > 0 && child->box.height > 0) {
+		view_update_child_extents(child->view);
+	}
+
 	wl_list_remove(&child->surface_commit.link);
 	wl_list_remove(&child->surface_destroy.link);
 	wl_list_remove(&child->view_unmap.link);
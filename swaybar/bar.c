@@ -105,7 +105,7 @@ static void add_layer_surface(struct swaybar_output *output) {
 	bool hidden = strcmp(config->mode, "hide") == 0;
 	bool overlay = !hidden && strcmp(config->mode, "overlay") == 0;
 	output->layer_surface = zwlr_layer_shell_v1_get_layer_surface(
-			bar->layer_shell, output->surface, output->output,
+			bar->client->layer_shell, output->surface, output->output,
 			hidden || overlay ? ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY :
 			ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, "panel");
 	assert(output->layer_surface);
@@ -114,7 +114,8 @@ static void add_layer_surface(struct swaybar_output *output) {
 
 	if (overlay) {
 		// Empty input region
-		output->input_region = wl_compositor_create_region(bar->compositor);
+		output->input_region =
+			wl_compositor_create_region(bar->client->compositor);
 		assert(output->input_region);
 
 		wl_surface_set_input_region(output->surface, output->input_region);
@@ -144,6 +145,13 @@ void set_bar_dirty(struct swaybar *bar) {
 	}
 }
 
+void set_all_bars_dirty(struct swaybar_client *client) {
+	struct swaybar *bar;
+	wl_list_for_each(bar, &client->bars, link) {
+		set_bar_dirty(bar);
+	}
+}
+
 bool determine_bar_visibility(struct swaybar *bar, bool moving_layer) {
 	struct swaybar_config *config = bar->config;
 	bool visible = !(strcmp(config->mode, "invisible") == 0 ||
@@ -219,7 +227,7 @@ static void output_scale(void *data, struct wl_output *wl_output,
 
 	bool render = false;
 	struct swaybar_seat *seat;
-	wl_list_for_each(seat, &output->bar->seats, link) {
+	wl_list_for_each(seat, &output->bar->client->seats, link) {
 		if (output == seat->pointer.current) {
 			update_cursor(seat);
 			render = true;
@@ -266,7 +274,7 @@ static void xdg_output_handle_done(void *data,
 		wl_list_remove(&output->link);
 		wl_list_insert(&bar->outputs, &output->link);
 
-		output->surface = wl_compositor_create_surface(bar->compositor);
+		output->surface = wl_compositor_create_surface(bar->client->compositor);
 		assert(output->surface);
 
 		determine_bar_visibility(bar, false);
@@ -312,18 +320,36 @@ static void add_xdg_output(struct swaybar_output *output) {
 	if (output->xdg_output != NULL) {
 		return;
 	}
-	assert(output->bar->xdg_output_manager != NULL);
+	struct swaybar_client *client = output->bar->client;
+	assert(client->xdg_output_manager != NULL);
 	output->xdg_output = zxdg_output_manager_v1_get_xdg_output(
-		output->bar->xdg_output_manager, output->output);
+		client->xdg_output_manager, output->output);
 	zxdg_output_v1_add_listener(output->xdg_output, &xdg_output_listener,
 		output);
 }
 
+static void add_output(struct swaybar *bar, struct wl_registry *registry,
+		uint32_t name) {
+	struct swaybar_output *output = calloc(1, sizeof(struct swaybar_output));
+	output->bar = bar;
+	output->output = wl_registry_bind(registry, name,
+			&wl_output_interface, 3);
+	wl_output_add_listener(output->output, &output_listener, output);
+	output->scale = 1;
+	output->wl_name = name;
+	wl_list_init(&output->workspaces);
+	wl_list_init(&output->hotspots);
+	wl_list_init(&output->link);
+	if (bar->client->xdg_output_manager != NULL) {
+		add_xdg_output(output);
+	}
+}
+
 static void handle_global(void *data, struct wl_registry *registry,
 		uint32_t name, const char *interface, uint32_t version) {
-	struct swaybar *bar = data;
+	struct swaybar_client *client = data;
 	if (strcmp(interface, wl_compositor_interface.name) == 0) {
-		bar->compositor = wl_registry_bind(registry, name,
+		client->compositor = wl_registry_bind(registry, name,
 				&wl_compositor_interface, 4);
 	} else if (strcmp(interface, wl_seat_interface.name) == 0) {
 		struct swaybar_seat *seat = calloc(1, sizeof(struct swaybar_seat));
@@ -331,50 +357,49 @@ static void handle_global(void *data, struct wl_registry *registry,
 			sway_abort("Failed to allocate swaybar_seat");
 			return;
 		}
-		seat->bar = bar;
+		seat->client = client;
 		seat->wl_name = name;
 		seat->wl_seat = wl_registry_bind(registry, name, &wl_seat_interface, 3);
 		wl_seat_add_listener(seat->wl_seat, &seat_listener, seat);
-		wl_list_insert(&bar->seats, &seat->link);
+		wl_list_insert(&client->seats, &seat->link);
 	} else if (strcmp(interface, wl_shm_interface.name) == 0) {
-		bar->shm = wl_registry_bind(registry, name,
+		client->shm = wl_registry_bind(registry, name,
 				&wl_shm_interface, 1);
 	} else if (strcmp(interface, wl_output_interface.name) == 0) {
-		struct swaybar_output *output =
-			calloc(1, sizeof(struct swaybar_output));
-		output->bar = bar;
-		output->output = wl_registry_bind(registry, name,
-				&wl_output_interface, 3);
-		wl_output_add_listener(output->output, &output_listener, output);
-		output->scale = 1;
-		output->wl_name = name;
-		wl_list_init(&output->workspaces);
-		wl_list_init(&output->hotspots);
-		wl_list_init(&output->link);
-		if (bar->xdg_output_manager != NULL) {
-			add_xdg_output(output);
+		// Each bar has its own surfaces, so binds the output for itself
+		struct swaybar *bar;
+		wl_list_for_each(bar, &client->bars, link) {
+			add_output(bar, registry, name);
 		}
 	} else if (strcmp(interface, zwlr_layer_shell_v1_interface.name) == 0) {
-		bar->layer_shell = wl_registry_bind(
+		client->layer_shell = wl_registry_bind(
 				registry, name, &zwlr_layer_shell_v1_interface, 1);
 	} else if (strcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
-		bar->xdg_output_manager = wl_registry_bind(registry, name,
+		client->xdg_output_manager = wl_registry_bind(registry, name,
 			&zxdg_output_manager_v1_interface, 2);
 	}
 }
 
 static void handle_global_remove(void *data, struct wl_registry *registry,
 		uint32_t name) {
-	struct swaybar *bar = data;
-	struct swaybar_output *output, *tmp;
-	wl_list_for_each_safe(output, tmp, &bar->outputs, link) {
-		if (output->wl_name == name) {
-			swaybar_output_free(output);
-			return;
+	struct swaybar_client *client = data;
+	bool found = false;
+	struct swaybar *bar;
+	wl_list_for_each(bar, &client->bars, link) {
+		struct swaybar_output *output, *tmp;
+		wl_list_for_each_safe(output, tmp, &bar->outputs, link) {
+			if (output->wl_name == name) {
+				swaybar_output_free(output);
+				found = true;
+				break;
+			}
 		}
 	}
+	if (found) {
+		return;
+	}
 	struct swaybar_seat *seat, *tmp_seat;
-	wl_list_for_each_safe(seat, tmp_seat, &bar->seats, link) {
+	wl_list_for_each_safe(seat, tmp_seat, &client->seats, link) {
 		if (seat->wl_name == name) {
 			swaybar_seat_free(seat);
 			return;
@@ -387,75 +412,132 @@ static const struct wl_registry_listener registry_listener = {
 	.global_remove = handle_global_remove,
 };
 
-bool bar_setup(struct swaybar *bar, const char *socket_path) {
+static void free_outputs(struct wl_list *list) {
+	struct swaybar_output *output, *tmp;
+	wl_list_for_each_safe(output, tmp, list, link) {
+		swaybar_output_free(output);
+	}
+}
+
+static void free_seats(struct wl_list *list) {
+	struct swaybar_seat *seat, *tmp;
+	wl_list_for_each_safe(seat, tmp, list, link) {
+		swaybar_seat_free(seat);
+	}
+}
+
+static void swaybar_free(struct swaybar *bar) {
+	free_outputs(&bar->outputs);
+	if (bar->config) {
+		free_config(bar->config);
+	}
+	if (bar->status) {
+		status_line_free(bar->status);
+	}
+	free(bar->id);
+	free(bar->mode);
+	free(bar);
+}
+
+static struct swaybar *bar_create(struct swaybar_client *client,
+		const char *id) {
+	struct swaybar *bar = calloc(1, sizeof(struct swaybar));
+	if (!bar) {
+		sway_log(SWAY_ERROR, "Failed to allocate swaybar");
+		return NULL;
+	}
+	bar->client = client;
+	bar->id = strdup(id);
 	bar->visible = true;
 	bar->config = init_config();
 	wl_list_init(&bar->outputs);
-	wl_list_init(&bar->seats);
-	bar->eventloop = loop_create();
+	wl_list_init(&bar->link);
 
-	bar->ipc_socketfd = ipc_open_socket(socket_path);
-	bar->ipc_event_socketfd = ipc_open_socket(socket_path);
 	if (!ipc_initialize(bar)) {
-		return false;
+		swaybar_free(bar);
+		return NULL;
 	}
 	if (bar->config->status_command) {
 		bar->status = status_line_init(bar->config->status_command);
 		bar->status->bar = bar;
 	}
+	return bar;
+}
+
+bool bar_setup(struct swaybar_client *client, const char *socket_path,
+		list_t *bar_ids) {
+	wl_list_init(&client->bars);
+	wl_list_init(&client->seats);
+	client->eventloop = loop_create();
+
+	client->ipc_socketfd = ipc_open_socket(socket_path);
+	client->ipc_event_socketfd = ipc_open_socket(socket_path);
+	for (int i = 0; i < bar_ids->length; ++i) {
+		struct swaybar *bar = bar_create(client, bar_ids->items[i]);
+		if (bar) {
+			wl_list_insert(client->bars.prev, &bar->link);
+		}
+	}
+	if (wl_list_empty(&client->bars)) {
+		return false;
+	}
+	ipc_subscribe(client);
 
-	bar->display = wl_display_connect(NULL);
-	if (!bar->display) {
+	client->display = wl_display_connect(NULL);
+	if (!client->display) {
 		sway_abort("Unable to connect to the compositor. "
 				"If your compositor is running, check or set the "
 				"WAYLAND_DISPLAY environment variable.");
 	}
 
-	struct wl_registry *registry = wl_display_get_registry(bar->display);
-	wl_registry_add_listener(registry, &registry_listener, bar);
-	wl_display_roundtrip(bar->display);
-	assert(bar->compositor && bar->layer_shell && bar->shm &&
-		bar->xdg_output_manager);
+	struct wl_registry *registry = wl_display_get_registry(client->display);
+	wl_registry_add_listener(registry, &registry_listener, client);
+	wl_display_roundtrip(client->display);
+	assert(client->compositor && client->layer_shell && client->shm &&
+		client->xdg_output_manager);
 
 	// Second roundtrip for xdg-output
-	wl_display_roundtrip(bar->display);
+	wl_display_roundtrip(client->display);
 
 	struct swaybar_seat *seat;
-	wl_list_for_each(seat, &bar->seats, link) {
+	wl_list_for_each(seat, &client->seats, link) {
 		struct swaybar_pointer *pointer = &seat->pointer;
 		if (!pointer) {
 			continue;
 		}
 		pointer->cursor_surface =
-			wl_compositor_create_surface(bar->compositor);
+			wl_compositor_create_surface(client->compositor);
 		assert(pointer->cursor_surface);
 	}
 
+	struct swaybar *bar;
 #if HAVE_TRAY
-	if (!bar->config->tray_hidden) {
-		bar->tray = create_tray(bar);
+	// One tray serves every bar which shows it
+	wl_list_for_each(bar, &client->bars, link) {
+		if (!bar->config->tray_hidden) {
+			client->tray = create_tray(client);
+			break;
+		}
 	}
 #endif
 
-	if (bar->config->workspace_buttons) {
-		ipc_get_workspaces(bar);
+	ipc_get_workspaces(client);
+	wl_list_for_each(bar, &client->bars, link) {
+		determine_bar_visibility(bar, false);
 	}
-	determine_bar_visibility(bar, false);
 	return true;
 }
 
 static void display_in(int fd, short mask, void *data) {
-	struct swaybar *bar = data;
-	if (wl_display_dispatch(bar->display) == -1) {
-		bar->running = false;
+	struct swaybar_client *client = data;
+	if (wl_display_dispatch(client->display) == -1) {
+		client->running = false;
 	}
 }
 
 static void ipc_in(int fd, short mask, void *data) {
-	struct swaybar *bar = data;
-	if (handle_ipc_readable(bar)) {
-		set_bar_dirty(bar);
-	}
+	struct swaybar_client *client = data;
+	handle_ipc_readable(client);
 }
 
 static void status_in(int fd, short mask, void *data) {
@@ -463,62 +545,49 @@ static void status_in(int fd, short mask, void *data) {
 	if (mask & (POLLHUP | POLLERR)) {
 		status_error(bar->status, "[error reading from status command]");
 		set_bar_dirty(bar);
-		loop_remove_fd(bar->eventloop, fd);
+		loop_remove_fd(bar->client->eventloop, fd);
 	} else if (status_handle_readable(bar->status)) {
 		set_bar_dirty(bar);
 	}
 }
 
-void bar_run(struct swaybar *bar) {
-	loop_add_fd(bar->eventloop, wl_display_get_fd(bar->display), POLLIN,
-			display_in, bar);
-	loop_add_fd(bar->eventloop, bar->ipc_event_socketfd, POLLIN, ipc_in, bar);
-	if (bar->status) {
-		loop_add_fd(bar->eventloop, bar->status->read_fd, POLLIN,
-				status_in, bar);
+void bar_run(struct swaybar_client *client) {
+	loop_add_fd(client->eventloop, wl_display_get_fd(client->display), POLLIN,
+			display_in, client);
+	loop_add_fd(client->eventloop, client->ipc_event_socketfd, POLLIN,
+			ipc_in, client);
+	struct swaybar *bar;
+	wl_list_for_each(bar, &client->bars, link) {
+		if (bar->status) {
+			loop_add_fd(client->eventloop, bar->status->read_fd, POLLIN,
+					status_in, bar);
+		}
 	}
 #if HAVE_TRAY
-	if (bar->tray) {
-		loop_add_fd(bar->eventloop, bar->tray->fd, POLLIN, tray_in, bar->tray->bus);
+	if (client->tray) {
+		loop_add_fd(client->eventloop, client->tray->fd, POLLIN, tray_in,
+				client->tray->bus);
 	}
 #endif
-	while (bar->running) {
+	while (client->running) {
 		errno = 0;
-		if (wl_display_flush(bar->display) == -1 && errno != EAGAIN) {
+		if (wl_display_flush(client->display) == -1 && errno != EAGAIN) {
 			break;
 		}
-		loop_poll(bar->eventloop);
-	}
-}
-
-static void free_outputs(struct wl_list *list) {
-	struct swaybar_output *output, *tmp;
-	wl_list_for_each_safe(output, tmp, list, link) {
-		swaybar_output_free(output);
-	}
-}
-
-static void free_seats(struct wl_list *list) {
-	struct swaybar_seat *seat, *tmp;
-	wl_list_for_each_safe(seat, tmp, list, link) {
-		swaybar_seat_free(seat);
+		loop_poll(client->eventloop);
 	}
 }
 
-void bar_teardown(struct swaybar *bar) {
+void bar_teardown(struct swaybar_client *client) {
 #if HAVE_TRAY
-	destroy_tray(bar->tray);
+	destroy_tray(client->tray);
 #endif
-	free_outputs(&bar->outputs);
-	free_seats(&bar->seats);
-	if (bar->config) {
-		free_config(bar->config);
-	}
-	close(bar->ipc_event_socketfd);
-	close(bar->ipc_socketfd);
-	if (bar->status) {
-		status_line_free(bar->status);
-	}
-	free(bar->id);
-	free(bar->mode);
+	struct swaybar *bar, *tmp;
+	wl_list_for_each_safe(bar, tmp, &client->bars, link) {
+		wl_list_remove(&bar->link);
+		swaybar_free(bar);
+	}
+	free_seats(&client->seats);
+	close(client->ipc_event_socketfd);
+	close(client->ipc_socketfd);
 }
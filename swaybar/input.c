@@ -80,7 +80,7 @@ void update_cursor(struct swaybar_seat *seat) {
 	}
 	int scale = pointer->current ? pointer->current->scale : 1;
 	pointer->cursor_theme = wl_cursor_theme_load(
-		cursor_theme, cursor_size * scale, seat->bar->shm);
+		cursor_theme, cursor_size * scale, seat->client->shm);
 	struct wl_cursor *cursor;
 	cursor = wl_cursor_theme_get_cursor(pointer->cursor_theme, "left_ptr");
 	pointer->cursor_image = cursor->images[0];
@@ -96,19 +96,27 @@ void update_cursor(struct swaybar_seat *seat) {
 	wl_surface_commit(pointer->cursor_surface);
 }
 
+static struct swaybar_output *find_output(struct swaybar_client *client,
+		struct wl_surface *surface) {
+	struct swaybar *bar;
+	wl_list_for_each(bar, &client->bars, link) {
+		struct swaybar_output *output;
+		wl_list_for_each(output, &bar->outputs, link) {
+			if (output->surface == surface) {
+				return output;
+			}
+		}
+	}
+	return NULL;
+}
+
 static void wl_pointer_enter(void *data, struct wl_pointer *wl_pointer,
 		uint32_t serial, struct wl_surface *surface,
 		wl_fixed_t surface_x, wl_fixed_t surface_y) {
 	struct swaybar_seat *seat = data;
 	struct swaybar_pointer *pointer = &seat->pointer;
 	pointer->serial = serial;
-	struct swaybar_output *output;
-	wl_list_for_each(output, &seat->bar->outputs, link) {
-		if (output->surface == surface) {
-			pointer->current = output;
-			break;
-		}
-	}
+	pointer->current = find_output(seat->client, surface);
 	update_cursor(seat);
 }
 
@@ -164,7 +172,7 @@ static void wl_pointer_button(void *data, struct wl_pointer *wl_pointer,
 		return;
 	}
 
-	if (check_bindings(seat->bar, button, state)) {
+	if (check_bindings(output->bar, button, state)) {
 		return;
 	}
 
@@ -224,8 +232,9 @@ static void wl_pointer_axis(void *data, struct wl_pointer *wl_pointer,
 	// If there is a button press binding, execute it, skip default behavior,
 	// and check button release bindings
 	uint32_t button = wl_axis_to_button(axis, value);
-	if (check_bindings(seat->bar, button, WL_POINTER_BUTTON_STATE_PRESSED)) {
-		check_bindings(seat->bar, button, WL_POINTER_BUTTON_STATE_RELEASED);
+	struct swaybar *bar = output->bar;
+	if (check_bindings(bar, button, WL_POINTER_BUTTON_STATE_PRESSED)) {
+		check_bindings(bar, button, WL_POINTER_BUTTON_STATE_RELEASED);
 		return;
 	}
 
@@ -244,10 +253,10 @@ static void wl_pointer_axis(void *data, struct wl_pointer *wl_pointer,
 		}
 	}
 
-	struct swaybar_config *config = seat->bar->config;
+	struct swaybar_config *config = bar->config;
 	double amt = wl_fixed_to_double(value);
 	if (amt == 0.0 || !config->workspace_buttons) {
-		check_bindings(seat->bar, button, WL_POINTER_BUTTON_STATE_RELEASED);
+		check_bindings(bar, button, WL_POINTER_BUTTON_STATE_RELEASED);
 		return;
 	}
 
@@ -255,10 +264,10 @@ static void wl_pointer_axis(void *data, struct wl_pointer *wl_pointer,
 		return;
 	}
 
-	workspace_next(seat->bar, output, amt < 0.0);
+	workspace_next(bar, output, amt < 0.0);
 
 	// Check button release bindings
-	check_bindings(seat->bar, button, WL_POINTER_BUTTON_STATE_RELEASED);
+	check_bindings(bar, button, WL_POINTER_BUTTON_STATE_RELEASED);
 }
 
 static void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
@@ -313,13 +322,7 @@ static void wl_touch_down(void *data, struct wl_touch *wl_touch,
 		uint32_t serial, uint32_t time, struct wl_surface *surface,
 		int32_t id, wl_fixed_t _x, wl_fixed_t _y) {
 	struct swaybar_seat *seat = data;
-	struct swaybar_output *_output = NULL, *output = NULL;
-	wl_list_for_each(_output, &seat->bar->outputs, link) {
-		if (_output->surface == surface) {
-			output = _output;
-			break;
-		}
-	}
+	struct swaybar_output *output = find_output(seat->client, surface);
 	if (!output) {
 		sway_log(SWAY_DEBUG, "Got touch event for unknown surface");
 		return;
@@ -366,7 +369,7 @@ static void wl_touch_motion(void *data, struct wl_touch *wl_touch,
 	int progress = (int)((slot->x - slot->start_x)
 			/ slot->output->width * 100);
 	if (abs(progress) / 20 != abs(prev_progress) / 20) {
-		workspace_next(seat->bar, slot->output, progress - prev_progress < 0);
+		workspace_next(slot->output->bar, slot->output, progress - prev_progress < 0);
 	}
 }
 
@@ -415,9 +418,9 @@ static void seat_handle_capabilities(void *data, struct wl_seat *wl_seat,
 	}
 	if ((caps & WL_SEAT_CAPABILITY_POINTER)) {
 		seat->pointer.pointer = wl_seat_get_pointer(wl_seat);
-		if (seat->bar->running && !seat->pointer.cursor_surface) {
+		if (seat->client->running && !seat->pointer.cursor_surface) {
 			seat->pointer.cursor_surface =
-				wl_compositor_create_surface(seat->bar->compositor);
+				wl_compositor_create_surface(seat->client->compositor);
 			assert(seat->pointer.cursor_surface);
 		}
 		wl_pointer_add_listener(seat->pointer.pointer, &pointer_listener, seat);
@@ -34,7 +34,8 @@ void ipc_send_workspace_command(struct swaybar *bar, const char *ws) {
 		command[d++] = ws[i];
 	}
 
-	ipc_single_command(bar->ipc_socketfd, IPC_COMMAND, command, &size);
+	ipc_single_command(bar->client->ipc_socketfd,
+			IPC_COMMAND, command, &size);
 	free(command);
 }
 
@@ -352,80 +353,105 @@ static bool ipc_parse_config(
 	return true;
 }
 
-bool ipc_get_workspaces(struct swaybar *bar) {
+static struct swaybar_workspace *create_workspace(
+		struct swaybar_config *config, json_object *ws_json) {
+	json_object *num, *name, *visible, *focused, *urgent;
+	json_object_object_get_ex(ws_json, "num", &num);
+	json_object_object_get_ex(ws_json, "name", &name);
+	json_object_object_get_ex(ws_json, "visible", &visible);
+	json_object_object_get_ex(ws_json, "focused", &focused);
+	json_object_object_get_ex(ws_json, "urgent", &urgent);
+
+	struct swaybar_workspace *ws = calloc(1, sizeof(struct swaybar_workspace));
+	ws->num = json_object_get_int(num);
+	ws->name = strdup(json_object_get_string(name));
+	ws->label = strdup(ws->name);
+	// ws->num will be -1 if workspace name doesn't begin with int.
+	if (ws->num != -1) {
+		size_t len_offset = snprintf(NULL, 0, "%d", ws->num);
+		if (config->strip_workspace_name) {
+			free(ws->label);
+			ws->label = malloc(len_offset + 1);
+			snprintf(ws->label, len_offset + 1, "%d", ws->num);
+		} else if (config->strip_workspace_numbers) {
+			len_offset += ws->label[len_offset] == ':';
+			if (ws->name[len_offset] != '\0') {
+				free(ws->label);
+				// Strip number prefix [1-?:] using len_offset.
+				ws->label = strdup(ws->name + len_offset);
+			}
+		}
+	}
+	ws->visible = json_object_get_boolean(visible);
+	ws->focused = json_object_get_boolean(focused);
+	ws->urgent = json_object_get_boolean(urgent);
+	return ws;
+}
+
+void ipc_get_workspaces(struct swaybar_client *client) {
+	bool wanted = false;
+	struct swaybar *bar;
 	struct swaybar_output *output;
-	wl_list_for_each(output, &bar->outputs, link) {
-		free_workspaces(&output->workspaces);
-		output->focused = false;
+	wl_list_for_each(bar, &client->bars, link) {
+		if (!bar->config->workspace_buttons) {
+			continue;
+		}
+		wanted = true;
+		wl_list_for_each(output, &bar->outputs, link) {
+			free_workspaces(&output->workspaces);
+			output->focused = false;
+		}
 	}
+	if (!wanted) {
+		return;
+	}
+
+	// One request serves every bar
 	uint32_t len = 0;
-	char *res = ipc_single_command(bar->ipc_socketfd,
+	char *res = ipc_single_command(client->ipc_socketfd,
 			IPC_GET_WORKSPACES, NULL, &len);
 	json_object *results = json_tokener_parse(res);
 	if (!results) {
 		free(res);
-		return false;
+		return;
 	}
 
-	bar->visible_by_urgency = false;
 	size_t length = json_object_array_length(results);
-	json_object *ws_json;
-	json_object *num, *name, *visible, *focused, *out, *urgent;
-	for (size_t i = 0; i < length; ++i) {
-		ws_json = json_object_array_get_idx(results, i);
-
-		json_object_object_get_ex(ws_json, "num", &num);
-		json_object_object_get_ex(ws_json, "name", &name);
-		json_object_object_get_ex(ws_json, "visible", &visible);
-		json_object_object_get_ex(ws_json, "focused", &focused);
-		json_object_object_get_ex(ws_json, "output", &out);
-		json_object_object_get_ex(ws_json, "urgent", &urgent);
-
-		wl_list_for_each(output, &bar->outputs, link) {
+	wl_list_for_each(bar, &client->bars, link) {
+		if (!bar->config->workspace_buttons) {
+			continue;
+		}
+		bar->visible_by_urgency = false;
+		for (size_t i = 0; i < length; ++i) {
+			json_object *ws_json = json_object_array_get_idx(results, i);
+			json_object *out;
+			json_object_object_get_ex(ws_json, "output", &out);
 			const char *ws_output = json_object_get_string(out);
-			if (strcmp(ws_output, output->name) == 0) {
-				struct swaybar_workspace *ws =
-					calloc(1, sizeof(struct swaybar_workspace));
-				ws->num = json_object_get_int(num);
-				ws->name = strdup(json_object_get_string(name));
-				ws->label = strdup(ws->name);
-				// ws->num will be -1 if workspace name doesn't begin with int.
-				if (ws->num != -1) {
-					size_t len_offset = snprintf(NULL, 0, "%d", ws->num);
-					if (bar->config->strip_workspace_name) {
-						free(ws->label);
-						ws->label = malloc(len_offset + 1);
-						snprintf(ws->label, len_offset + 1, "%d", ws->num);
-					} else if (bar->config->strip_workspace_numbers) {
-						len_offset += ws->label[len_offset] == ':';
-						if (ws->name[len_offset] != '\0') {
-							free(ws->label);
-							// Strip number prefix [1-?:] using len_offset.
-							ws->label = strdup(ws->name + len_offset);
-						}
-					}
+
+			wl_list_for_each(output, &bar->outputs, link) {
+				if (strcmp(ws_output, output->name) != 0) {
+					continue;
 				}
-				ws->visible = json_object_get_boolean(visible);
-				ws->focused = json_object_get_boolean(focused);
+				struct swaybar_workspace *ws =
+					create_workspace(bar->config, ws_json);
 				if (ws->focused) {
 					output->focused = true;
 				}
-				ws->urgent = json_object_get_boolean(urgent);
 				if (ws->urgent) {
 					bar->visible_by_urgency = true;
 				}
 				wl_list_insert(output->workspaces.prev, &ws->link);
 			}
 		}
+		determine_bar_visibility(bar, false);
 	}
 	json_object_put(results);
 	free(res);
-	return determine_bar_visibility(bar, false);
 }
 
 static void ipc_get_outputs(struct swaybar *bar) {
 	uint32_t len = 0;
-	char *res = ipc_single_command(bar->ipc_socketfd,
+	char *res = ipc_single_command(bar->client->ipc_socketfd,
 			IPC_GET_OUTPUTS, NULL, &len);
 	json_object *outputs = json_tokener_parse(res);
 	for (size_t i = 0; i < json_object_array_length(outputs); ++i) {
@@ -462,13 +488,13 @@ void ipc_execute_binding(struct swaybar *bar, struct swaybar_binding *bind) {
 	sway_log(SWAY_DEBUG, "Executing binding for button %u (release=%d): `%s`",
 			bind->button, bind->release, bind->command);
 	uint32_t len = strlen(bind->command);
-	free(ipc_single_command(bar->ipc_socketfd,
+	free(ipc_single_command(bar->client->ipc_socketfd,
 			IPC_COMMAND, bind->command, &len));
 }
 
 bool ipc_initialize(struct swaybar *bar) {
 	uint32_t len = strlen(bar->id);
-	char *res = ipc_single_command(bar->ipc_socketfd,
+	char *res = ipc_single_command(bar->client->ipc_socketfd,
 			IPC_GET_BAR_CONFIG, bar->id, &len);
 	if (!ipc_parse_config(bar->config, res)) {
 		free(res);
@@ -476,16 +502,23 @@ bool ipc_initialize(struct swaybar *bar) {
 	}
 	free(res);
 	ipc_get_outputs(bar);
+	return true;
+}
+
+void ipc_subscribe(struct swaybar_client *client) {
+	bool mode = false, workspace = false;
+	struct swaybar *bar;
+	wl_list_for_each(bar, &client->bars, link) {
+		mode |= bar->config->binding_mode_indicator;
+		workspace |= bar->config->workspace_buttons;
+	}
 
-	struct swaybar_config *config = bar->config;
 	char subscribe[128]; // suitably large buffer
-	len = snprintf(subscribe, 128,
+	uint32_t len = snprintf(subscribe, 128,
 			"[ \"barconfig_update\" , \"bar_state_update\" %s %s ]",
-			config->binding_mode_indicator ? ", \"mode\"" : "",
-			config->workspace_buttons ? ", \"workspace\"" : "");
-	free(ipc_single_command(bar->ipc_event_socketfd,
+			mode ? ", \"mode\"" : "", workspace ? ", \"workspace\"" : "");
+	free(ipc_single_command(client->ipc_event_socketfd,
 			IPC_SUBSCRIBE, subscribe, &len));
-	return true;
 }
 
 static bool handle_bar_state_update(struct swaybar *bar, json_object *event) {
@@ -561,54 +594,63 @@ static bool handle_barconfig_update(struct swaybar *bar,
 	return determine_bar_visibility(bar, true);
 }
 
-bool handle_ipc_readable(struct swaybar *bar) {
-	struct ipc_response *resp = ipc_recv_response(bar->ipc_event_socketfd);
-	if (!resp) {
+static bool handle_mode(struct swaybar *bar, json_object *result) {
+	json_object *json_change, *json_pango_markup;
+	if (!json_object_object_get_ex(result, "change", &json_change)) {
+		sway_log(SWAY_ERROR, "failed to parse response");
 		return false;
 	}
+	const char *change = json_object_get_string(json_change);
+	free(bar->mode);
+	bar->mode = strcmp(change, "default") != 0 ? strdup(change) : NULL;
+	bar->visible_by_mode = bar->mode != NULL;
+	determine_bar_visibility(bar, false);
+	if (json_object_object_get_ex(result,
+				"pango_markup", &json_pango_markup)) {
+		bar->mode_pango_markup = json_object_get_boolean(json_pango_markup);
+	}
+	return true;
+}
+
+void handle_ipc_readable(struct swaybar_client *client) {
+	struct ipc_response *resp = ipc_recv_response(client->ipc_event_socketfd);
+	if (!resp) {
+		return;
+	}
 
 	json_object *result = json_tokener_parse(resp->payload);
 	if (!result) {
 		sway_log(SWAY_ERROR, "failed to parse payload as json");
 		free_ipc_response(resp);
-		return false;
+		return;
 	}
 
-	bool bar_is_dirty = true;
-	switch (resp->type) {
-	case IPC_EVENT_WORKSPACE:
-		bar_is_dirty = ipc_get_workspaces(bar);
-		break;
-	case IPC_EVENT_MODE: {
-		json_object *json_change, *json_pango_markup;
-		if (json_object_object_get_ex(result, "change", &json_change)) {
-			const char *change = json_object_get_string(json_change);
-			free(bar->mode);
-			bar->mode = strcmp(change, "default") != 0 ? strdup(change) : NULL;
-			bar->visible_by_mode = bar->mode != NULL;
-			determine_bar_visibility(bar, false);
-		} else {
-			sway_log(SWAY_ERROR, "failed to parse response");
-			bar_is_dirty = false;
-			break;
-		}
-		if (json_object_object_get_ex(result,
-					"pango_markup", &json_pango_markup)) {
-			bar->mode_pango_markup = json_object_get_boolean(json_pango_markup);
+	if (resp->type == IPC_EVENT_WORKSPACE) {
+		ipc_get_workspaces(client);
+	} else {
+		// The other events are handled by each bar they concern
+		struct swaybar *bar;
+		wl_list_for_each(bar, &client->bars, link) {
+			bool bar_is_dirty = false;
+			switch (resp->type) {
+			case IPC_EVENT_MODE:
+				bar_is_dirty = bar->config->binding_mode_indicator &&
+					handle_mode(bar, result);
+				break;
+			case IPC_EVENT_BARCONFIG_UPDATE:
+				bar_is_dirty = handle_barconfig_update(bar, result);
+				break;
+			case IPC_EVENT_BAR_STATE_UPDATE:
+				bar_is_dirty = handle_bar_state_update(bar, result);
+				break;
+			default:
+				break;
+			}
+			if (bar_is_dirty) {
+				set_bar_dirty(bar);
+			}
 		}
-		break;
-	}
-	case IPC_EVENT_BARCONFIG_UPDATE:
-		bar_is_dirty = handle_barconfig_update(bar, result);
-		break;
-	case IPC_EVENT_BAR_STATE_UPDATE:
-		bar_is_dirty = handle_bar_state_update(bar, result);
-		break;
-	default:
-		bar_is_dirty = false;
-		break;
 	}
 	json_object_put(result);
 	free_ipc_response(resp);
-	return bar_is_dirty;
 }
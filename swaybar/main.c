@@ -6,9 +6,10 @@
 #include <getopt.h>
 #include "swaybar/bar.h"
 #include "ipc-client.h"
+#include "list.h"
 #include "log.h"
 
-static struct swaybar swaybar;
+static struct swaybar_client swaybar;
 
 void sig_handler(int signal) {
 	swaybar.running = false;
@@ -16,6 +17,7 @@ void sig_handler(int signal) {
 
 int main(int argc, char **argv) {
 	char *socket_path = NULL;
+	list_t *bar_ids = create_list();
 	bool debug = false;
 
 	static struct option long_options[] = {
@@ -34,6 +36,7 @@ int main(int argc, char **argv) {
 		"  -v, --version          Show the version number and quit.\n"
 		"  -s, --socket <socket>  Connect to sway via socket.\n"
 		"  -b, --bar_id <id>      Bar ID for which to get the configuration.\n"
+		"                         May be repeated to serve several bars.\n"
 		"  -d, --debug            Enable debugging.\n"
 		"\n"
 		" PLEASE NOTE that swaybar will be automatically started by sway as\n"
@@ -52,7 +55,7 @@ int main(int argc, char **argv) {
 			socket_path = strdup(optarg);
 			break;
 		case 'b': // Type
-			swaybar.id = strdup(optarg);
+			list_add(bar_ids, strdup(optarg));
 			break;
 		case 'v':
 			fprintf(stdout, "swaybar version " SWAY_VERSION "\n");
@@ -73,7 +76,7 @@ int main(int argc, char **argv) {
 		sway_log_init(SWAY_INFO, NULL);
 	}
 
-	if (!swaybar.id) {
+	if (bar_ids->length == 0) {
 		sway_log(SWAY_ERROR, "No bar_id passed. "
 				"Provide --bar_id or let sway start swaybar");
 		return 1;
@@ -87,12 +90,14 @@ int main(int argc, char **argv) {
 		}
 	}
 
-	if (!bar_setup(&swaybar, socket_path)) {
+	if (!bar_setup(&swaybar, socket_path, bar_ids)) {
 		free(socket_path);
+		list_free_items_and_destroy(bar_ids);
 		return 1;
 	}
 
 	free(socket_path);
+	list_free_items_and_destroy(bar_ids);
 
 	signal(SIGINT, sig_handler);
 	signal(SIGTERM, sig_handler);
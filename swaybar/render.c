@@ -641,7 +641,7 @@ static uint32_t render_to_cairo(cairo_t *cairo, struct swaybar_output *output) {
 	 */
 	double x = output->width * output->scale;
 #if HAVE_TRAY
-	if (bar->tray) {
+	if (bar->client->tray && !config->tray_hidden) {
 		uint32_t h = render_tray(cairo, output, &x);
 		max_height = h > max_height ? h : max_height;
 	}
@@ -724,7 +724,7 @@ void render_frame(struct swaybar_output *output) {
 		wl_surface_commit(output->surface);
 	} else if (height > 0) {
 		// Replay recording into shm and send it off
-		output->current_buffer = get_next_buffer(output->bar->shm,
+		output->current_buffer = get_next_buffer(output->bar->client->shm,
 				output->buffers,
 				output->width * output->scale,
 				output->height * output->scale);
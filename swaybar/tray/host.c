@@ -57,7 +57,7 @@ static int handle_sni_unregistered(sd_bus_message *msg, void *data,
 		sway_log(SWAY_INFO, "Unregistering Status Notifier Item '%s'", id);
 		destroy_sni(tray->items->items[idx]);
 		list_del(tray->items, idx);
-		set_bar_dirty(tray->bar);
+		set_all_bars_dirty(tray->client);
 	}
 	return ret;
 }
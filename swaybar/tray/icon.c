@@ -1,11 +1,14 @@
 #define _POSIX_C_SOURCE 200809L
 #include <ctype.h>
 #include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #include <wordexp.h>
 #include "swaybar/tray/icon.h"
@@ -289,24 +292,412 @@ static struct icon_theme *read_theme_file(char *basedir, char *theme_name) {
 	}
 }
 
-static list_t *load_themes_in_dir(char *basedir) {
+/*
+ * The cache holds one record per index.theme file, in the order they were
+ * found. Invalid files are recorded too so they aren't parsed again:
+ *
+ *   T path mtime_sec mtime_nsec size valid
+ *   F dir
+ *   N name
+ *   C comment
+ *   I inherits
+ *   D directory,directory,...
+ *   S name size type max_size min_size threshold
+ *
+ * Fields are separated by tabs. Only T is present for invalid files.
+ */
+#define THEME_CACHE_HEADER "swaybar icon theme cache 1"
+
+struct theme_cache_entry {
+	char *path;
+	struct timespec mtime;
+	off_t size;
+	struct icon_theme *theme; // NULL if the file is invalid
+};
+
+static void destroy_cache_entry(struct theme_cache_entry *entry,
+		bool destroy_theme_too) {
+	if (destroy_theme_too) {
+		destroy_theme(entry->theme);
+	}
+	free(entry->path);
+	free(entry);
+}
+
+static char *get_theme_cache_path(void) {
+	const char *cache_home = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	const char *fmt = "%s/sway/icon-themes";
+	if (!(cache_home && *cache_home)) {
+		if (!(home && *home)) {
+			return NULL;
+		}
+		cache_home = home;
+		fmt = "%s/.cache/sway/icon-themes";
+	}
+	size_t len = snprintf(NULL, 0, fmt, cache_home) + 1;
+	char *path = malloc(len);
+	if (path) {
+		snprintf(path, len, fmt, cache_home);
+	}
+	return path;
+}
+
+/*
+ * Splits line into at most max tab separated fields, in place. Returns the
+ * number of fields.
+ */
+static int split_fields(char *line, char **fields, int max) {
+	int n = 0;
+	while (line) {
+		if (n == max) {
+			return -1; // more fields than expected
+		}
+		fields[n++] = line;
+		line = strchr(line, '\t');
+		if (line) {
+			*line++ = '\0';
+		}
+	}
+	return n;
+}
+
+static bool parse_int(const char *str, long long *out) {
+	char *end;
+	errno = 0;
+	*out = strtoll(str, &end, 10);
+	return errno == 0 && *str && *end == '\0';
+}
+
+static bool read_cached_theme_line(struct icon_theme *theme,
+		char **fields, int n) {
+	char type = fields[0][0];
+	if (fields[0][1] != '\0' || (type != 'S' && n != 2)) {
+		return false;
+	}
+	switch (type) {
+	case 'F':
+		free(theme->dir);
+		theme->dir = strdup(fields[1]);
+		break;
+	case 'N':
+		free(theme->name);
+		theme->name = strdup(fields[1]);
+		break;
+	case 'C':
+		free(theme->comment);
+		theme->comment = strdup(fields[1]);
+		break;
+	case 'I':
+		free(theme->inherits);
+		theme->inherits = strdup(fields[1]);
+		break;
+	case 'D':
+		list_free_items_and_destroy(theme->directories);
+		theme->directories = split_string(fields[1], ",");
+		break;
+	case 'S': {
+		long long v[5];
+		if (n != 7) {
+			return false;
+		}
+		for (int i = 0; i < 5; ++i) {
+			if (!parse_int(fields[i + 2], &v[i])) {
+				return false;
+			}
+		}
+		if (v[1] < THRESHOLD || v[1] > FIXED) {
+			return false;
+		}
+		struct icon_theme_subdir *subdir =
+			calloc(1, sizeof(struct icon_theme_subdir));
+		if (!subdir) {
+			return false;
+		}
+		subdir->name = strdup(fields[1]);
+		subdir->size = v[0];
+		subdir->type = v[1];
+		subdir->max_size = v[2];
+		subdir->min_size = v[3];
+		subdir->threshold = v[4];
+		list_add(theme->subdirs, subdir);
+		break;
+	}
+	default:
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Returns the cached entries, or an empty list if the cache is missing or
+ * can't be read.
+ */
+static list_t *read_theme_cache(const char *path) {
+	list_t *entries = create_list();
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return entries;
+	}
+
+	bool error = false;
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t nread = getline(&line, &line_size, f);
+	if (nread <= 0 || strcmp(line, THEME_CACHE_HEADER "\n") != 0) {
+		error = true;
+	}
+
+	struct theme_cache_entry *entry = NULL;
+	while (!error && (nread = getline(&line, &line_size, f)) != -1) {
+		if (nread == 0 || line[nread - 1] != '\n') {
+			error = true;
+			break;
+		}
+		line[nread - 1] = '\0';
+
+		char *fields[7];
+		int n = split_fields(line, fields, 7);
+		if (n < 2) {
+			error = true;
+		} else if (strcmp(fields[0], "T") == 0) {
+			long long v[4];
+			error = n != 6;
+			for (int i = 0; !error && i < 4; ++i) {
+				error = !parse_int(fields[i + 2], &v[i]);
+			}
+			if (error) {
+				break;
+			}
+			entry = calloc(1, sizeof(struct theme_cache_entry));
+			if (!entry) {
+				error = true;
+				break;
+			}
+			entry->path = strdup(fields[1]);
+			entry->mtime.tv_sec = v[0];
+			entry->mtime.tv_nsec = v[1];
+			entry->size = v[2];
+			list_add(entries, entry);
+			if (v[3]) {
+				entry->theme = calloc(1, sizeof(struct icon_theme));
+				if (!entry->theme) {
+					error = true;
+					break;
+				}
+				entry->theme->subdirs = create_list();
+			}
+		} else if (entry && entry->theme) {
+			error = !read_cached_theme_line(entry->theme, fields, n);
+		} else {
+			error = true;
+		}
+	}
+	free(line);
+	fclose(f);
+
+	for (int i = 0; !error && i < entries->length; ++i) {
+		struct theme_cache_entry *e = entries->items[i];
+		error = e->theme && !(validate_icon_theme(e->theme) && e->theme->dir);
+	}
+	if (error) {
+		for (int i = 0; i < entries->length; ++i) {
+			destroy_cache_entry(entries->items[i], true);
+		}
+		entries->length = 0;
+	}
+	return entries;
+}
+
+static bool cacheable(const char *str) {
+	return !str || !strpbrk(str, "\t\n");
+}
+
+static bool theme_cacheable(struct icon_theme *theme) {
+	if (!cacheable(theme->dir) || !cacheable(theme->name) ||
+			!cacheable(theme->comment) || !cacheable(theme->inherits)) {
+		return false;
+	}
+	for (int i = 0; i < theme->directories->length; ++i) {
+		const char *dir = theme->directories->items[i];
+		if (!cacheable(dir) || strchr(dir, ',')) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void write_cache_entry(FILE *f, struct theme_cache_entry *entry) {
+	struct icon_theme *theme = entry->theme;
+	fprintf(f, "T\t%s\t%lld\t%ld\t%lld\t%d\n", entry->path,
+			(long long)entry->mtime.tv_sec, entry->mtime.tv_nsec,
+			(long long)entry->size, theme != NULL);
+	if (!theme) {
+		return;
+	}
+	fprintf(f, "F\t%s\nN\t%s\nC\t%s\n", theme->dir, theme->name,
+			theme->comment);
+	if (theme->inherits) {
+		fprintf(f, "I\t%s\n", theme->inherits);
+	}
+	fputs("D\t", f);
+	for (int i = 0; i < theme->directories->length; ++i) {
+		fprintf(f, "%s%s", i ? "," : "",
+				(char *)theme->directories->items[i]);
+	}
+	fputc('\n', f);
+	for (int i = 0; i < theme->subdirs->length; ++i) {
+		struct icon_theme_subdir *subdir = theme->subdirs->items[i];
+		fprintf(f, "S\t%s\t%d\t%d\t%d\t%d\t%d\n", subdir->name,
+				subdir->size, subdir->type, subdir->max_size,
+				subdir->min_size, subdir->threshold);
+	}
+}
+
+static void make_parent_dirs(char *path) {
+	for (char *slash = strchr(path + 1, '/'); slash;
+			slash = strchr(slash + 1, '/')) {
+		*slash = '\0';
+		mkdir(path, 0700);
+		*slash = '/';
+	}
+}
+
+/*
+ * Writes the cache to a temporary file, then renames it over the old one so
+ * concurrent readers never see a partial cache.
+ */
+static void write_theme_cache(char *path, list_t *entries) {
+	make_parent_dirs(path);
+	size_t tmp_len = snprintf(NULL, 0, "%s.%d", path, getpid()) + 1;
+	char *tmp = malloc(tmp_len);
+	if (!tmp) {
+		return;
+	}
+	snprintf(tmp, tmp_len, "%s.%d", path, getpid());
+	FILE *f = fopen(tmp, "w");
+	if (!f) {
+		free(tmp);
+		return;
+	}
+
+	fputs(THEME_CACHE_HEADER "\n", f);
+	for (int i = 0; i < entries->length; ++i) {
+		struct theme_cache_entry *entry = entries->items[i];
+		if (cacheable(entry->path) &&
+				(!entry->theme || theme_cacheable(entry->theme))) {
+			write_cache_entry(f, entry);
+		}
+	}
+
+	bool failed = ferror(f);
+	if (fclose(f) != 0 || failed || rename(tmp, path) != 0) {
+		unlink(tmp);
+	}
+	free(tmp);
+}
+
+static struct theme_cache_entry *take_cache_entry(list_t *cache,
+		const char *path, struct stat *sb) {
+	for (int i = 0; i < cache->length; ++i) {
+		struct theme_cache_entry *entry = cache->items[i];
+		if (strcmp(entry->path, path) != 0) {
+			continue;
+		}
+		list_del(cache, i);
+		if (entry->mtime.tv_sec == sb->st_mtim.tv_sec &&
+				entry->mtime.tv_nsec == sb->st_mtim.tv_nsec &&
+				entry->size == sb->st_size) {
+			return entry;
+		}
+		destroy_cache_entry(entry, true);
+		return NULL;
+	}
+	return NULL;
+}
+
+/*
+ * Adds the themes found in basedir to themes, reusing the cached ones which
+ * are still up to date. Returns the number of index.theme files parsed.
+ */
+static int load_themes_in_dir(char *basedir, list_t *themes, list_t *cache,
+		list_t *entries) {
 	DIR *dir;
 	if (!(dir = opendir(basedir))) {
-		return NULL;
+		return 0;
 	}
 
-	list_t *themes = create_list();
-	struct dirent *entry;
-	while ((entry = readdir(dir))) {
-		if (entry->d_name[0] == '.') continue;
+	int parsed = 0;
+	struct dirent *dirent;
+	while ((dirent = readdir(dir))) {
+		if (dirent->d_name[0] == '.') continue;
 
-		struct icon_theme *theme = read_theme_file(basedir, entry->d_name);
-		if (theme) {
-			list_add(themes, theme);
+		size_t path_len = snprintf(NULL, 0, "%s/%s/index.theme", basedir,
+				dirent->d_name) + 1;
+		char *path = malloc(path_len);
+		if (!path) {
+			continue;
+		}
+		snprintf(path, path_len, "%s/%s/index.theme", basedir, dirent->d_name);
+		struct stat sb;
+		if (stat(path, &sb) != 0) {
+			free(path);
+			continue;
+		}
+
+		struct theme_cache_entry *entry = take_cache_entry(cache, path, &sb);
+		if (entry) {
+			free(path);
+		} else {
+			entry = calloc(1, sizeof(struct theme_cache_entry));
+			if (!entry) {
+				free(path);
+				continue;
+			}
+			entry->path = path;
+			entry->mtime = sb.st_mtim;
+			entry->size = sb.st_size;
+			entry->theme = read_theme_file(basedir, dirent->d_name);
+			++parsed;
+		}
+		list_add(entries, entry);
+		if (entry->theme) {
+			list_add(themes, entry->theme);
 		}
 	}
 	closedir(dir);
-	return themes;
+	return parsed;
+}
+
+static void *load_themes(void *data) {
+	struct icon_theme_loader *loader = data;
+	char *cache_path = get_theme_cache_path();
+	list_t *cache = cache_path ? read_theme_cache(cache_path) : create_list();
+	list_t *entries = create_list();
+
+	for (int i = 0; i < loader->basedirs->length; ++i) {
+		loader->parsed += load_themes_in_dir(loader->basedirs->items[i],
+				loader->themes, cache, entries);
+	}
+
+	// Whatever is left in the cache is gone from the disk
+	if (cache_path && (loader->parsed > 0 || cache->length > 0)) {
+		write_theme_cache(cache_path, entries);
+	}
+	for (int i = 0; i < cache->length; ++i) {
+		destroy_cache_entry(cache->items[i], true);
+	}
+	list_free(cache);
+	for (int i = 0; i < entries->length; ++i) {
+		destroy_cache_entry(entries->items[i], false);
+	}
+	list_free(entries);
+	free(cache_path);
+
+	// Closing our end wakes up the main loop
+	close(loader->done_fd);
+	loader->done_fd = -1;
+	return NULL;
 }
 
 static void log_loaded_themes(list_t *themes) {
@@ -346,24 +737,49 @@ static void log_loaded_themes(list_t *themes) {
 	free(str);
 }
 
-void init_themes(list_t **themes, list_t **basedirs) {
-	*basedirs = get_basedirs();
-
-	*themes = create_list();
-	for (int i = 0; i < (*basedirs)->length; ++i) {
-		list_t *dir_themes = load_themes_in_dir((*basedirs)->items[i]);
-		if (dir_themes == NULL) {
-			continue;
-		}
-		list_cat(*themes, dir_themes);
-		list_free(dir_themes);
-	}
+bool init_themes(struct icon_theme_loader *loader) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		sway_log_errno(SWAY_ERROR, "Unable to create pipe for icon themes");
+		return false;
+	}
+	loader->fd = fds[0];
+	loader->done_fd = fds[1];
+	loader->parsed = 0;
+	// Expanded here, as wordexp isn't thread safe
+	loader->basedirs = get_basedirs();
+	loader->themes = create_list();
+
+	int ret = pthread_create(&loader->thread, NULL, load_themes, loader);
+	if (ret != 0) {
+		sway_log(SWAY_ERROR, "Unable to start loading icon themes: %s",
+				strerror(ret));
+		close(fds[0]);
+		close(fds[1]);
+		loader->fd = -1;
+		finish_themes(loader->themes, loader->basedirs);
+		loader->themes = loader->basedirs = NULL;
+		return false;
+	}
+	return true;
+}
 
-	log_loaded_themes(*themes);
+void finish_loading_themes(struct icon_theme_loader *loader,
+		list_t **themes, list_t **basedirs) {
+	pthread_join(loader->thread, NULL);
+	close(loader->fd);
+	loader->fd = -1;
+
+	sway_log(SWAY_DEBUG, "Parsed %d icon theme index files, %d themes loaded",
+			loader->parsed, loader->themes->length);
+	log_loaded_themes(loader->themes);
+	*themes = loader->themes;
+	*basedirs = loader->basedirs;
+	loader->themes = loader->basedirs = NULL;
 }
 
 void finish_themes(list_t *themes, list_t *basedirs) {
-	for (int i = 0; i < themes->length; ++i) {
+	for (int i = 0; themes && i < themes->length; ++i) {
 		destroy_theme(themes->items[i]);
 	}
 	list_free(themes);
@@ -1,7 +1,9 @@
 #define _POSIX_C_SOURCE 200809L
 #include <arpa/inet.h>
 #include <cairo.h>
+#include <errno.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include "swaybar/bar.h"
@@ -15,25 +17,56 @@
 #include "cairo.h"
 #include "list.h"
 #include "log.h"
+#include "loop.h"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 
 // TODO menu
 
+// How long to wait for more signals before fetching an item's properties, in ms
+#define SNI_REFETCH_DELAY 100
+
 static bool sni_ready(struct swaybar_sni *sni) {
 	return sni->status && (sni->status[0] == 'N' ? // NeedsAttention
 			sni->attention_icon_name || sni->attention_icon_pixmap :
 			sni->icon_name || sni->icon_pixmap);
 }
 
+static void destroy_sni_icon(struct swaybar_sni_icon *icon) {
+	cairo_surface_destroy(icon->surface);
+	free(icon->theme);
+	free(icon);
+}
+
+void sni_invalidate_icons(struct swaybar_sni *sni) {
+	for (int i = 0; i < sni->icons->length; ++i) {
+		destroy_sni_icon(sni->icons->items[i]);
+	}
+	sni->icons->length = 0;
+}
+
 static void set_sni_dirty(struct swaybar_sni *sni) {
 	if (sni_ready(sni)) {
-		sni->min_size = sni->max_size = 0; // invalidate previous icon
-		set_bar_dirty(sni->tray->bar);
+		sni_invalidate_icons(sni);
+		set_all_bars_dirty(sni->tray->client);
 	}
 }
 
+static bool pixmaps_equal(list_t *a, list_t *b) {
+	if (!a || !b || a->length != b->length) {
+		return false;
+	}
+	for (int i = 0; i < a->length; ++i) {
+		struct swaybar_pixmap *pa = a->items[i], *pb = b->items[i];
+		if (pa->size != pb->size ||
+				memcmp(pa->pixels, pb->pixels, pa->size * pa->size * 4) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
 static int read_pixmap(sd_bus_message *msg, struct swaybar_sni *sni,
-		const char *prop, list_t **dest) {
+		const char *prop, list_t **dest, bool *changed) {
 	int ret = sd_bus_message_enter_container(msg, 'a', "(iiay)");
 	if (ret < 0) {
 		sway_log(SWAY_ERROR, "%s %s: %s", sni->watcher_id, prop, strerror(-ret));
@@ -42,7 +75,7 @@ static int read_pixmap(sd_bus_message *msg, struct swaybar_sni *sni,
 
 	if (sd_bus_message_at_end(msg, 0)) {
 		sway_log(SWAY_DEBUG, "%s %s no. of icons = 0", sni->watcher_id, prop);
-		return ret;
+		return sd_bus_message_exit_container(msg);
 	}
 
 	list_t *pixmaps = create_list();
@@ -72,7 +105,8 @@ static int read_pixmap(sd_bus_message *msg, struct swaybar_sni *sni,
 			goto error;
 		}
 
-		if (height > 0 && width == height) {
+		if (height > 0 && width == height &&
+				npixels == (size_t)width * height * 4) {
 			sway_log(SWAY_DEBUG, "%s %s: found icon w:%d h:%d", sni->watcher_id, prop, width, height);
 			struct swaybar_pixmap *pixmap =
 				malloc(sizeof(struct swaybar_pixmap) + npixels);
@@ -91,13 +125,24 @@ static int read_pixmap(sd_bus_message *msg, struct swaybar_sni *sni,
 		sd_bus_message_exit_container(msg);
 	}
 
+	ret = sd_bus_message_exit_container(msg);
+	if (ret < 0) {
+		goto error;
+	}
+
 	if (pixmaps->length < 1) {
 		sway_log(SWAY_DEBUG, "%s %s no. of icons = 0", sni->watcher_id, prop);
 		goto error;
 	}
 
+	// Blinking items resend the same few icons over and over
+	if (pixmaps_equal(*dest, pixmaps)) {
+		list_free_items_and_destroy(pixmaps);
+		return ret;
+	}
 	list_free_items_and_destroy(*dest);
 	*dest = pixmaps;
+	*changed = true;
 	sway_log(SWAY_DEBUG, "%s %s no. of icons = %d", sni->watcher_id, prop,
 			pixmaps->length);
 
@@ -107,82 +152,185 @@ error:
 	return ret;
 }
 
-struct get_property_data {
-	struct swaybar_sni *sni;
-	const char *prop;
-	const char *type;
-	void *dest;
+struct sni_property {
+	const char *name;
+	const char *type; // NULL for pixmaps
+	size_t offset;
+	bool visible; // whether it affects what is drawn
 };
 
-static int get_property_callback(sd_bus_message *msg, void *data,
+// Ignored: Category, Id, Title, WindowId, OverlayIconName,
+//          OverlayIconPixmap, AttentionMovieName, ToolTip
+static const struct sni_property sni_properties[] = {
+	{ "Status", "s", offsetof(struct swaybar_sni, status), true },
+	{ "IconName", "s", offsetof(struct swaybar_sni, icon_name), true },
+	{ "IconPixmap", NULL, offsetof(struct swaybar_sni, icon_pixmap), true },
+	{ "AttentionIconName", "s",
+		offsetof(struct swaybar_sni, attention_icon_name), true },
+	{ "AttentionIconPixmap", NULL,
+		offsetof(struct swaybar_sni, attention_icon_pixmap), true },
+	{ "ItemIsMenu", "b", offsetof(struct swaybar_sni, item_is_menu), false },
+	{ "Menu", "o", offsetof(struct swaybar_sni, menu), false },
+	// non-standard KDE property
+	{ "IconThemePath", "s",
+		offsetof(struct swaybar_sni, icon_theme_path), true },
+};
+
+/*
+ * Reads the value of prop, which the message must be at. Sets changed if it
+ * differs from the current value. A value of the wrong type is skipped.
+ */
+static int read_property(sd_bus_message *msg, struct swaybar_sni *sni,
+		const struct sni_property *prop, bool *changed) {
+	void *dest = (char *)sni + prop->offset;
+	const char *type = prop->type;
+	int ret = sd_bus_message_enter_container(msg, 'v', type ? type : "a(iiay)");
+	if (ret == -ENXIO) {
+		sway_log(SWAY_DEBUG, "%s %s: unexpected type, ignoring",
+				sni->watcher_id, prop->name);
+		return sd_bus_message_skip(msg, "v");
+	}
+	if (ret < 0) {
+		sway_log(SWAY_ERROR, "%s %s: %s", sni->watcher_id, prop->name,
+				strerror(-ret));
+		return ret;
+	}
+
+	if (!type) {
+		ret = read_pixmap(msg, sni, prop->name, dest, changed);
+	} else if (*type == 's' || *type == 'o') {
+		const char *value;
+		ret = sd_bus_message_read_basic(msg, *type, &value);
+		char **str = dest;
+		if (ret >= 0 && (!*str || strcmp(*str, value) != 0)) {
+			free(*str);
+			*str = strdup(value);
+			*changed = true;
+			sway_log(SWAY_DEBUG, "%s %s = '%s'", sni->watcher_id, prop->name,
+					*str);
+		}
+	} else {
+		int value;
+		ret = sd_bus_message_read_basic(msg, 'b', &value);
+		if (ret >= 0 && *(bool *)dest != !!value) {
+			*(bool *)dest = value;
+			*changed = true;
+			sway_log(SWAY_DEBUG, "%s %s = %s", sni->watcher_id, prop->name,
+					value ? "true" : "false");
+		}
+	}
+	if (ret < 0) {
+		sway_log(SWAY_ERROR, "%s %s: %s", sni->watcher_id, prop->name,
+				strerror(-ret));
+		return ret;
+	}
+	return sd_bus_message_exit_container(msg);
+}
+
+static void sni_fetch_properties(struct swaybar_sni *sni);
+
+static int get_all_callback(sd_bus_message *msg, void *data,
 		sd_bus_error *error) {
-	struct get_property_data *d = data;
-	struct swaybar_sni *sni = d->sni;
-	const char *prop = d->prop;
-	const char *type = d->type;
-	void *dest = d->dest;
+	struct swaybar_sni *sni = data;
+	sni->get_all_slot = sd_bus_slot_unref(sni->get_all_slot);
 
 	int ret;
 	if (sd_bus_message_is_method_error(msg, NULL)) {
-		sway_log(SWAY_ERROR, "%s %s: %s", sni->watcher_id, prop,
+		sway_log(SWAY_ERROR, "%s properties: %s", sni->watcher_id,
 				sd_bus_message_get_error(msg)->message);
 		ret = sd_bus_message_get_errno(msg);
-		goto cleanup;
+		goto refetch;
 	}
 
-	ret = sd_bus_message_enter_container(msg, 'v', type);
+	ret = sd_bus_message_enter_container(msg, 'a', "{sv}");
 	if (ret < 0) {
-		sway_log(SWAY_ERROR, "%s %s: %s", sni->watcher_id, prop, strerror(-ret));
-		goto cleanup;
+		sway_log(SWAY_ERROR, "%s properties: %s", sni->watcher_id,
+				strerror(-ret));
+		goto refetch;
 	}
 
-	if (!type) {
-		ret = read_pixmap(msg, sni, prop, dest);
+	bool redraw = false;
+	while ((ret = sd_bus_message_enter_container(msg, 'e', "sv")) > 0) {
+		const char *name;
+		ret = sd_bus_message_read_basic(msg, 's', &name);
 		if (ret < 0) {
-			goto cleanup;
-		}
-	} else {
-		if (*type == 's' || *type == 'o') {
-			free(*(char **)dest);
+			break;
 		}
 
-		ret = sd_bus_message_read(msg, type, dest);
+		const struct sni_property *prop = NULL;
+		for (size_t i = 0; i < sizeof(sni_properties) /
+				sizeof(*sni_properties); ++i) {
+			if (strcmp(sni_properties[i].name, name) == 0) {
+				prop = &sni_properties[i];
+				break;
+			}
+		}
+		if (prop) {
+			bool changed = false;
+			ret = read_property(msg, sni, prop, &changed);
+			redraw |= changed && prop->visible;
+		} else {
+			ret = sd_bus_message_skip(msg, "v");
+		}
 		if (ret < 0) {
-			sway_log(SWAY_ERROR, "%s %s: %s", sni->watcher_id, prop, strerror(-ret));
-			goto cleanup;
+			break;
 		}
 
-		if (*type == 's' || *type == 'o') {
-			char **str = dest;
-			*str = strdup(*str);
-			sway_log(SWAY_DEBUG, "%s %s = '%s'", sni->watcher_id, prop, *str);
-		} else if (*type == 'b') {
-			sway_log(SWAY_DEBUG, "%s %s = %s", sni->watcher_id, prop,
-					*(bool *)dest ? "true" : "false");
+		ret = sd_bus_message_exit_container(msg);
+		if (ret < 0) {
+			break;
 		}
 	}
+	if (ret < 0) {
+		sway_log(SWAY_ERROR, "%s properties: %s", sni->watcher_id,
+				strerror(-ret));
+	}
 
-	if (strcmp(prop, "Status") == 0 || (sni->status && (sni->status[0] == 'N' ?
-				prop[0] == 'A' : strncmp(prop, "Icon", 4) == 0))) {
+	// Whatever was read is drawn, all at once
+	if (redraw) {
 		set_sni_dirty(sni);
 	}
-cleanup:
-	free(data);
+
+refetch:
+	if (sni->refetch_pending) {
+		sni->refetch_pending = false;
+		sni_fetch_properties(sni);
+	}
 	return ret;
 }
 
-static void sni_get_property_async(struct swaybar_sni *sni, const char *prop,
-		const char *type, void *dest) {
-	struct get_property_data *data = malloc(sizeof(struct get_property_data));
-	data->sni = sni;
-	data->prop = prop;
-	data->type = type;
-	data->dest = dest;
-	int ret = sd_bus_call_method_async(sni->tray->bus, NULL, sni->service,
-			sni->path, "org.freedesktop.DBus.Properties", "Get",
-			get_property_callback, data, "ss", sni->interface, prop);
+/*
+ * Fetches all properties in a single call. If a fetch is already under way,
+ * another one is made once it is done, as its reply may predate the change.
+ */
+static void sni_fetch_properties(struct swaybar_sni *sni) {
+	if (sni->get_all_slot) {
+		sni->refetch_pending = true;
+		return;
+	}
+	int ret = sd_bus_call_method_async(sni->tray->bus, &sni->get_all_slot,
+			sni->service, sni->path, "org.freedesktop.DBus.Properties",
+			"GetAll", get_all_callback, sni, "s", sni->interface);
 	if (ret < 0) {
-		sway_log(SWAY_ERROR, "%s %s: %s", sni->watcher_id, prop, strerror(-ret));
+		sway_log(SWAY_ERROR, "%s properties: %s", sni->watcher_id,
+				strerror(-ret));
+	}
+}
+
+static void handle_refetch_timer(void *data) {
+	struct swaybar_sni *sni = data;
+	sni->refetch_timer = NULL;
+	sni_fetch_properties(sni);
+}
+
+/*
+ * Items can signal changes dozens of times per second, so a signal only
+ * schedules a fetch, which covers every signal arriving until it is made.
+ */
+static void sni_schedule_refetch(struct swaybar_sni *sni) {
+	if (!sni->refetch_timer) {
+		sni->refetch_timer = loop_add_timer(sni->tray->client->eventloop,
+				SNI_REFETCH_DELAY, handle_refetch_timer, sni);
 	}
 }
 
@@ -215,19 +363,14 @@ static int sni_check_msg_sender(struct swaybar_sni *sni, sd_bus_message *msg,
 
 static int handle_new_icon(sd_bus_message *msg, void *data, sd_bus_error *error) {
 	struct swaybar_sni *sni = data;
-	sni_get_property_async(sni, "IconName", "s", &sni->icon_name);
-	sni_get_property_async(sni, "IconPixmap", NULL, &sni->icon_pixmap);
-	if (!strcmp(sni->interface, "org.kde.StatusNotifierItem")) {
-		sni_get_property_async(sni, "IconThemePath", "s", &sni->icon_theme_path);
-	}
+	sni_schedule_refetch(sni);
 	return sni_check_msg_sender(sni, msg, "icon");
 }
 
 static int handle_new_attention_icon(sd_bus_message *msg, void *data,
 		sd_bus_error *error) {
 	struct swaybar_sni *sni = data;
-	sni_get_property_async(sni, "AttentionIconName", "s", &sni->attention_icon_name);
-	sni_get_property_async(sni, "AttentionIconPixmap", NULL, &sni->attention_icon_pixmap);
+	sni_schedule_refetch(sni);
 	return sni_check_msg_sender(sni, msg, "attention icon");
 }
 
@@ -241,13 +384,15 @@ static int handle_new_status(sd_bus_message *msg, void *data, sd_bus_error *erro
 			sway_log(SWAY_ERROR, "%s new status error: %s", sni->watcher_id, strerror(-ret));
 			ret = r;
 		} else {
-			free(sni->status);
-			sni->status = strdup(status);
 			sway_log(SWAY_DEBUG, "%s has new status = '%s'", sni->watcher_id, status);
-			set_sni_dirty(sni);
+			if (!sni->status || strcmp(sni->status, status) != 0) {
+				free(sni->status);
+				sni->status = strdup(status);
+				set_sni_dirty(sni);
+			}
 		}
 	} else {
-		sni_get_property_async(sni, "Status", "s", &sni->status);
+		sni_schedule_refetch(sni);
 	}
 
 	return ret;
@@ -269,6 +414,7 @@ struct swaybar_sni *create_sni(char *id, struct swaybar_tray *tray) {
 		return NULL;
 	}
 	sni->tray = tray;
+	sni->icons = create_list();
 	sni->watcher_id = strdup(id);
 	char *path_ptr = strchr(id, '/');
 	if (!path_ptr) {
@@ -279,18 +425,9 @@ struct swaybar_sni *create_sni(char *id, struct swaybar_tray *tray) {
 		sni->service = strndup(id, path_ptr - id);
 		sni->path = strdup(path_ptr);
 		sni->interface = "org.kde.StatusNotifierItem";
-		sni_get_property_async(sni, "IconThemePath", "s", &sni->icon_theme_path);
 	}
 
-	// Ignored: Category, Id, Title, WindowId, OverlayIconName,
-	//          OverlayIconPixmap, AttentionMovieName, ToolTip
-	sni_get_property_async(sni, "Status", "s", &sni->status);
-	sni_get_property_async(sni, "IconName", "s", &sni->icon_name);
-	sni_get_property_async(sni, "IconPixmap", NULL, &sni->icon_pixmap);
-	sni_get_property_async(sni, "AttentionIconName", "s", &sni->attention_icon_name);
-	sni_get_property_async(sni, "AttentionIconPixmap", NULL, &sni->attention_icon_pixmap);
-	sni_get_property_async(sni, "ItemIsMenu", "b", &sni->item_is_menu);
-	sni_get_property_async(sni, "Menu", "o", &sni->menu);
+	sni_fetch_properties(sni);
 
 	sni_match_signal(sni, &sni->new_icon_slot, "NewIcon", handle_new_icon);
 	sni_match_signal(sni, &sni->new_attention_icon_slot, "NewAttentionIcon",
@@ -305,8 +442,14 @@ void destroy_sni(struct swaybar_sni *sni) {
 		return;
 	}
 
-	cairo_surface_destroy(sni->icon);
+	sni_invalidate_icons(sni);
+	list_free(sni->icons);
 
+	if (sni->refetch_timer) {
+		loop_remove_timer(sni->tray->client->eventloop, sni->refetch_timer);
+	}
+	// Cancels the call if it is still pending
+	sd_bus_slot_unref(sni->get_all_slot);
 	sd_bus_slot_unref(sni->new_icon_slot);
 	sd_bus_slot_unref(sni->new_attention_icon_slot);
 	sd_bus_slot_unref(sni->new_status_slot);
@@ -324,11 +467,12 @@ void destroy_sni(struct swaybar_sni *sni) {
 	free(sni);
 }
 
-static void handle_click(struct swaybar_sni *sni, int x, int y,
+static void handle_click(struct swaybar_sni *sni,
+		struct swaybar_config *config, int x, int y,
 		uint32_t button, int delta) {
 	const char *method = NULL;
 	struct tray_binding *binding = NULL;
-	wl_list_for_each(binding, &sni->tray->bar->config->tray_bindings, link) {
+	wl_list_for_each(binding, &config->tray_bindings, link) {
 		if (binding->button == button) {
 			method = binding->command;
 			break;
@@ -379,20 +523,21 @@ static enum hotspot_event_handling icon_hotspot_callback(
 		int x, int y, uint32_t button, void *data) {
 	sway_log(SWAY_DEBUG, "Clicked on %s", (char *)data);
 
-	struct swaybar_tray *tray = output->bar->tray;
+	struct swaybar_tray *tray = output->bar->client->tray;
 	int idx = list_seq_find(tray->items, cmp_sni_id, data);
 
 	if (idx != -1) {
 		struct swaybar_sni *sni = tray->items->items[idx];
 		// guess global position since wayland doesn't expose it
-		struct swaybar_config *config = tray->bar->config;
+		struct swaybar_config *config = output->bar->config;
 		int global_x = output->output_x + config->gaps.left + x;
 		bool top_bar = config->position & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP;
 		int global_y = output->output_y + (top_bar ? config->gaps.top + y:
 				(int) output->output_height - config->gaps.bottom - y);
 
 		sway_log(SWAY_DEBUG, "Guessing click position at (%d, %d)", global_x, global_y);
-		handle_click(sni, global_x, global_y, button, 1); // TODO get delta from event
+		// TODO get delta from event
+		handle_click(sni, config, global_x, global_y, button, 1);
 		return HOTSPOT_IGNORE;
 	} else {
 		sway_log(SWAY_DEBUG, "but it doesn't exist");
@@ -401,61 +546,83 @@ static enum hotspot_event_handling icon_hotspot_callback(
 	return HOTSPOT_PROCESS;
 }
 
+static cairo_surface_t *load_sni_icon(struct swaybar_sni *sni, int size,
+		char *theme, int *min_size, int *max_size) {
+	char *icon_name = sni->status[0] == 'N' ?
+		sni->attention_icon_name : sni->icon_name;
+	if (icon_name && sni->tray->themes) {
+		char *icon_path = find_icon(sni->tray->themes, sni->tray->basedirs,
+				icon_name, size, theme, min_size, max_size);
+		if (!icon_path && sni->icon_theme_path) {
+			icon_path = find_icon_in_dir(icon_name, sni->icon_theme_path,
+					min_size, max_size);
+		}
+		if (icon_path) {
+			cairo_surface_t *icon = load_background_image(icon_path);
+			free(icon_path);
+			return icon;
+		}
+	}
+
+	list_t *pixmaps = sni->status[0] == 'N' ?
+		sni->attention_icon_pixmap : sni->icon_pixmap;
+	if (!pixmaps) {
+		return NULL;
+	}
+	int idx = -1;
+	unsigned smallest_error = -1; // UINT_MAX
+	for (int i = 0; i < pixmaps->length; ++i) {
+		struct swaybar_pixmap *pixmap = pixmaps->items[i];
+		unsigned error = (size - pixmap->size) *
+			(size < pixmap->size ? -1 : 1);
+		if (error < smallest_error) {
+			smallest_error = error;
+			idx = i;
+		}
+	}
+	// The pixmap is chosen by its distance to this exact size
+	*min_size = *max_size = size;
+	struct swaybar_pixmap *pixmap = pixmaps->items[idx];
+	return cairo_image_surface_create_for_data(pixmap->pixels,
+			CAIRO_FORMAT_ARGB32, pixmap->size, pixmap->size,
+			cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, pixmap->size));
+}
+
 uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 		struct swaybar_sni *sni) {
 	uint32_t height = output->height * output->scale;
 	int padding = output->bar->config->tray_padding;
 	int ideal_size = height - 2*padding;
-	if ((ideal_size < sni->min_size || ideal_size > sni->max_size) && sni_ready(sni)) {
-		bool icon_found = false;
-		char *icon_name = sni->status[0] == 'N' ?
-			sni->attention_icon_name : sni->icon_name;
-		if (icon_name) {
-			char *icon_path = find_icon(sni->tray->themes, sni->tray->basedirs,
-					icon_name, ideal_size, output->bar->config->icon_theme,
-					&sni->min_size, &sni->max_size);
-			if (!icon_path && sni->icon_theme_path) {
-				icon_path = find_icon_in_dir(icon_name, sni->icon_theme_path,
-						&sni->min_size, &sni->max_size);
-			}
-			if (icon_path) {
-				cairo_surface_destroy(sni->icon);
-				sni->icon = load_background_image(icon_path);
-				free(icon_path);
-				icon_found = true;
-			}
+	char *theme = output->bar->config->icon_theme;
+	struct swaybar_sni_icon *sni_icon = NULL;
+	for (int i = 0; i < sni->icons->length; ++i) {
+		struct swaybar_sni_icon *cached = sni->icons->items[i];
+		if (ideal_size >= cached->min_size && ideal_size <= cached->max_size &&
+				(theme && cached->theme ? strcmp(theme, cached->theme) == 0 :
+				theme == cached->theme)) {
+			sni_icon = cached;
+			break;
 		}
-		if (!icon_found) {
-			list_t *pixmaps = sni->status[0] == 'N' ?
-				sni->attention_icon_pixmap : sni->icon_pixmap;
-			if (pixmaps) {
-				int idx = -1;
-				unsigned smallest_error = -1; // UINT_MAX
-				for (int i = 0; i < pixmaps->length; ++i) {
-					struct swaybar_pixmap *pixmap = pixmaps->items[i];
-					unsigned error = (ideal_size - pixmap->size) *
-						(ideal_size < pixmap->size ? -1 : 1);
-					if (error < smallest_error) {
-						smallest_error = error;
-						idx = i;
-					}
-				}
-				struct swaybar_pixmap *pixmap = pixmaps->items[idx];
-				cairo_surface_destroy(sni->icon);
-				sni->icon = cairo_image_surface_create_for_data(pixmap->pixels,
-						CAIRO_FORMAT_ARGB32, pixmap->size, pixmap->size,
-						cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, pixmap->size));
-			}
+	}
+	if (!sni_icon && sni_ready(sni)) {
+		sni_icon = calloc(1, sizeof(struct swaybar_sni_icon));
+		if (sni_icon) {
+			sni_icon->theme = theme ? strdup(theme) : NULL;
+			sni_icon->min_size = sni_icon->max_size = ideal_size;
+			sni_icon->surface = load_sni_icon(sni, ideal_size, theme,
+					&sni_icon->min_size, &sni_icon->max_size);
+			list_add(sni->icons, sni_icon);
 		}
 	}
+	cairo_surface_t *surface = sni_icon ? sni_icon->surface : NULL;
 
 	int icon_size;
 	cairo_surface_t *icon;
-	if (sni->icon) {
-		int actual_size = cairo_image_surface_get_height(sni->icon);
+	if (surface) {
+		int actual_size = cairo_image_surface_get_height(surface);
 		icon_size = actual_size < ideal_size ?
 			actual_size*(ideal_size/actual_size) : ideal_size;
-		icon = cairo_image_surface_scale(sni->icon, icon_size, icon_size);
+		icon = cairo_image_surface_scale(surface, icon_size, icon_size);
 	} else { // draw a :(
 		icon_size = ideal_size*0.8;
 		icon = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, icon_size, icon_size);
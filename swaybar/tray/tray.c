@@ -1,4 +1,5 @@
 #include <cairo.h>
+#include <poll.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +12,7 @@
 #include "swaybar/tray/watcher.h"
 #include "list.h"
 #include "log.h"
+#include "loop.h"
 
 static int handle_lost_watcher(sd_bus_message *msg,
 		void *data, sd_bus_error *error) {
@@ -33,7 +35,19 @@ static int handle_lost_watcher(sd_bus_message *msg,
 	return 0;
 }
 
-struct swaybar_tray *create_tray(struct swaybar *bar) {
+static void themes_in(int fd, short mask, void *data) {
+	struct swaybar_tray *tray = data;
+	loop_remove_fd(tray->client->eventloop, fd);
+	finish_loading_themes(&tray->theme_loader, &tray->themes, &tray->basedirs);
+
+	// Look the icons up again now that the themes are known
+	for (int i = 0; i < tray->items->length; ++i) {
+		sni_invalidate_icons(tray->items->items[i]);
+	}
+	set_all_bars_dirty(tray->client);
+}
+
+struct swaybar_tray *create_tray(struct swaybar_client *client) {
 	sway_log(SWAY_DEBUG, "Initializing tray");
 
 	sd_bus *bus;
@@ -47,7 +61,8 @@ struct swaybar_tray *create_tray(struct swaybar *bar) {
 	if (!tray) {
 		return NULL;
 	}
-	tray->bar = bar;
+	tray->client = client;
+	tray->theme_loader.fd = -1;
 	tray->bus = bus;
 	tray->fd = sd_bus_get_fd(tray->bus);
 
@@ -67,7 +82,12 @@ struct swaybar_tray *create_tray(struct swaybar *bar) {
 	init_host(&tray->host_xdg, "freedesktop", tray);
 	init_host(&tray->host_kde, "kde", tray);
 
-	init_themes(&tray->themes, &tray->basedirs);
+	// Icons are looked up once the themes are in, so the bar can be shown
+	// in the meantime
+	if (init_themes(&tray->theme_loader)) {
+		loop_add_fd(client->eventloop, tray->theme_loader.fd, POLLIN,
+				themes_in, tray);
+	}
 
 	return tray;
 }
@@ -85,6 +105,11 @@ void destroy_tray(struct swaybar_tray *tray) {
 	destroy_watcher(tray->watcher_xdg);
 	destroy_watcher(tray->watcher_kde);
 	sd_bus_flush_close_unref(tray->bus);
+	if (tray->theme_loader.fd != -1) {
+		loop_remove_fd(tray->client->eventloop, tray->theme_loader.fd);
+		finish_loading_themes(&tray->theme_loader,
+				&tray->themes, &tray->basedirs);
+	}
 	finish_themes(tray->themes, tray->basedirs);
 	free(tray);
 }
@@ -121,7 +146,7 @@ uint32_t render_tray(cairo_t *cairo, struct swaybar_output *output, double *x) {
 	}
 
 	uint32_t max_height = 0;
-	struct swaybar_tray *tray = output->bar->tray;
+	struct swaybar_tray *tray = output->bar->client->tray;
 	for (int i = 0; i < tray->items->length; ++i) {
 		uint32_t h = render_sni(cairo, output, x, tray->items->items[i]);
 		max_height = h > max_height ? h : max_height;
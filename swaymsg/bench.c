@@ -0,0 +1,453 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "ipc-client.h"
+#include "log.h"
+
+void sway_terminate(int exit_code) {
+	exit(exit_code);
+}
+
+enum bench_message {
+	BENCH_GET_TREE,
+	BENCH_GET_WORKSPACES,
+	BENCH_COMMAND,
+	BENCH_SUBSCRIBE,
+	BENCH_MESSAGE_COUNT,
+};
+
+static const struct {
+	const char *name;
+	uint32_t type;
+} messages[BENCH_MESSAGE_COUNT] = {
+	[BENCH_GET_TREE] = { "get_tree", IPC_GET_TREE },
+	[BENCH_GET_WORKSPACES] = { "get_workspaces", IPC_GET_WORKSPACES },
+	[BENCH_COMMAND] = { "command", IPC_COMMAND },
+	[BENCH_SUBSCRIBE] = { "subscribe", IPC_SUBSCRIBE },
+};
+
+struct latencies {
+	double *samples; // milliseconds
+	size_t length, capacity;
+	size_t sent;
+};
+
+struct connection {
+	int fd;
+	bool alive;
+	uint64_t rng;
+
+	bool waiting;
+	enum bench_message pending;
+	double sent_at;
+	double next_send_at;
+
+	char header[IPC_HEADER_SIZE];
+	size_t header_received;
+	uint32_t payload_size, payload_type;
+	size_t payload_received;
+};
+
+static struct {
+	int weights[BENCH_MESSAGE_COUNT];
+	int total_weight;
+	const char *command;
+	const char *subscription;
+	double interval_ms; // 0 for as fast as possible
+
+	struct latencies latencies[BENCH_MESSAGE_COUNT];
+	size_t events;
+	size_t disconnects;
+	size_t protocol_errors;
+} bench;
+
+static double now_msec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// xorshift64*, so runs with the same seed send the same sequence
+static uint64_t next_random(uint64_t *state) {
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static enum bench_message pick_message(struct connection *conn) {
+	int pick = next_random(&conn->rng) % bench.total_weight;
+	for (int i = 0; i < BENCH_MESSAGE_COUNT; ++i) {
+		if (pick < bench.weights[i]) {
+			return i;
+		}
+		pick -= bench.weights[i];
+	}
+	return BENCH_GET_WORKSPACES;
+}
+
+static bool parse_mix(char *mix) {
+	memset(bench.weights, 0, sizeof(bench.weights));
+	bench.total_weight = 0;
+	char *saveptr;
+	for (char *item = strtok_r(mix, ",", &saveptr); item;
+			item = strtok_r(NULL, ",", &saveptr)) {
+		char *value = strchr(item, '=');
+		int weight = 1;
+		if (value) {
+			*value++ = '\0';
+			char *end;
+			weight = strtol(value, &end, 10);
+			if (end == value || *end != '\0' || weight < 0) {
+				fprintf(stderr, "Invalid weight for %s\n", item);
+				return false;
+			}
+		}
+		int i;
+		for (i = 0; i < BENCH_MESSAGE_COUNT; ++i) {
+			if (strcasecmp(item, messages[i].name) == 0) {
+				bench.weights[i] = weight;
+				break;
+			}
+		}
+		if (i == BENCH_MESSAGE_COUNT) {
+			fprintf(stderr, "Unknown message type %s\n", item);
+			return false;
+		}
+		bench.total_weight += weight;
+	}
+	if (bench.total_weight == 0) {
+		fprintf(stderr, "The message mix is empty\n");
+		return false;
+	}
+	return true;
+}
+
+static void record_latency(enum bench_message message, double ms) {
+	struct latencies *lat = &bench.latencies[message];
+	if (lat->length == lat->capacity) {
+		size_t capacity = lat->capacity ? lat->capacity * 2 : 1024;
+		double *samples = realloc(lat->samples, capacity * sizeof(double));
+		if (!samples) {
+			sway_abort("Unable to allocate latency samples");
+		}
+		lat->samples = samples;
+		lat->capacity = capacity;
+	}
+	lat->samples[lat->length++] = ms;
+}
+
+static void drop_connection(struct connection *conn) {
+	if (conn->alive) {
+		close(conn->fd);
+		conn->alive = false;
+		bench.disconnects++;
+	}
+}
+
+static void send_next(struct connection *conn, double now) {
+	enum bench_message message = pick_message(conn);
+	const char *payload = "";
+	if (message == BENCH_COMMAND) {
+		payload = bench.command;
+	} else if (message == BENCH_SUBSCRIBE) {
+		payload = bench.subscription;
+	}
+	if (!ipc_send_message(conn->fd, messages[message].type, payload,
+				strlen(payload))) {
+		drop_connection(conn);
+		return;
+	}
+	bench.latencies[message].sent++;
+	conn->waiting = true;
+	conn->pending = message;
+	conn->sent_at = now;
+	conn->next_send_at += bench.interval_ms;
+	if (conn->next_send_at < now) {
+		// Fell behind, don't burst to catch up
+		conn->next_send_at = now;
+	}
+}
+
+/**
+ * Read whatever is available without blocking. Events received on subscribed
+ * connections are counted and skipped while waiting for the reply.
+ */
+static void handle_readable(struct connection *conn) {
+	if (conn->header_received < IPC_HEADER_SIZE) {
+		ssize_t received = recv(conn->fd, conn->header + conn->header_received,
+				IPC_HEADER_SIZE - conn->header_received, MSG_DONTWAIT);
+		if (received <= 0) {
+			if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+				return;
+			}
+			drop_connection(conn);
+			return;
+		}
+		conn->header_received += received;
+		if (conn->header_received < IPC_HEADER_SIZE) {
+			return;
+		}
+		if (!ipc_parse_header(conn->header,
+					&conn->payload_size, &conn->payload_type)) {
+			bench.protocol_errors++;
+			drop_connection(conn);
+			return;
+		}
+		conn->payload_received = 0;
+	}
+
+	char buf[4096];
+	while (conn->payload_received < conn->payload_size) {
+		size_t want = conn->payload_size - conn->payload_received;
+		if (want > sizeof(buf)) {
+			want = sizeof(buf);
+		}
+		ssize_t received = recv(conn->fd, buf, want, MSG_DONTWAIT);
+		if (received <= 0) {
+			if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+				return;
+			}
+			drop_connection(conn);
+			return;
+		}
+		conn->payload_received += received;
+	}
+
+	// Full message received
+	conn->header_received = 0;
+	if (conn->payload_type & 0x80000000) {
+		bench.events++;
+		return;
+	}
+	if (!conn->waiting || conn->payload_type != messages[conn->pending].type) {
+		bench.protocol_errors++;
+		return;
+	}
+	conn->waiting = false;
+	record_latency(conn->pending, now_msec() - conn->sent_at);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static void print_report(double elapsed_ms, int connections) {
+	size_t replies = 0;
+	printf("%-16s %8s %8s %9s %9s %9s %9s\n", "message", "sent", "replies",
+			"p50 (ms)", "p90 (ms)", "p99 (ms)", "max (ms)");
+	for (int i = 0; i < BENCH_MESSAGE_COUNT; ++i) {
+		struct latencies *lat = &bench.latencies[i];
+		if (!lat->sent) {
+			continue;
+		}
+		replies += lat->length;
+		if (!lat->length) {
+			printf("%-16s %8zu %8zu\n", messages[i].name, lat->sent, (size_t)0);
+			continue;
+		}
+		qsort(lat->samples, lat->length, sizeof(double), compare_doubles);
+		printf("%-16s %8zu %8zu %9.3f %9.3f %9.3f %9.3f\n", messages[i].name,
+				lat->sent, lat->length,
+				lat->samples[lat->length / 2],
+				lat->samples[lat->length * 90 / 100],
+				lat->samples[lat->length * 99 / 100],
+				lat->samples[lat->length - 1]);
+	}
+	printf("\n");
+	printf("connections:     %d\n", connections);
+	printf("duration:        %.1f s\n", elapsed_ms / 1000.0);
+	printf("throughput:      %.1f replies/s\n", replies * 1000.0 / elapsed_ms);
+	printf("events:          %zu\n", bench.events);
+	printf("disconnects:     %zu\n", bench.disconnects);
+	printf("protocol errors: %zu\n", bench.protocol_errors);
+}
+
+int main(int argc, char **argv) {
+	char *socket_path = NULL;
+	int connections = 4;
+	double duration = 10;
+	double rate = 10;
+	uint64_t seed = 1;
+	char *mix = strdup("get_tree=1,get_workspaces=4,command=1");
+	bench.command = "nop";
+	bench.subscription = "[\"workspace\",\"window\"]";
+
+	sway_log_init(SWAY_INFO, NULL);
+
+	static struct option long_options[] = {
+		{"help", no_argument, NULL, 'h'},
+		{"command", required_argument, NULL, 'C'},
+		{"connections", required_argument, NULL, 'c'},
+		{"duration", required_argument, NULL, 'd'},
+		{"mix", required_argument, NULL, 'm'},
+		{"rate", required_argument, NULL, 'r'},
+		{"socket", required_argument, NULL, 's'},
+		{"seed", required_argument, NULL, 'S'},
+		{"subscribe", required_argument, NULL, 'e'},
+		{0, 0, 0, 0}
+	};
+
+	const char *usage =
+		"Usage: swaymsg-bench [options]\n"
+		"\n"
+		"  -h, --help                 Show help message and quit.\n"
+		"  -c, --connections <n>      Number of concurrent connections. Default 4.\n"
+		"  -d, --duration <seconds>   How long to run for. Default 10.\n"
+		"  -r, --rate <n>             Messages per second per connection, or 0\n"
+		"                             for as fast as possible. Default 10.\n"
+		"  -m, --mix <type=weight,..> Weighted mix of get_tree, get_workspaces,\n"
+		"                             command and subscribe messages.\n"
+		"                             Default get_tree=1,get_workspaces=4,command=1.\n"
+		"  -C, --command <command>    Payload of command messages. Default nop.\n"
+		"  -e, --subscribe <json>     Payload of subscribe messages.\n"
+		"                             Default [\"workspace\",\"window\"].\n"
+		"  -S, --seed <n>             Seed for the message sequence. Default 1.\n"
+		"  -s, --socket <socket>      Use the specified socket.\n";
+
+	int c;
+	while (1) {
+		int option_index = 0;
+		c = getopt_long(argc, argv, "hC:c:d:m:r:s:S:e:", long_options,
+				&option_index);
+		if (c == -1) {
+			break;
+		}
+		switch (c) {
+		case 'C':
+			bench.command = optarg;
+			break;
+		case 'c':
+			connections = atoi(optarg);
+			break;
+		case 'd':
+			duration = atof(optarg);
+			break;
+		case 'e':
+			bench.subscription = optarg;
+			break;
+		case 'm':
+			free(mix);
+			mix = strdup(optarg);
+			break;
+		case 'r':
+			rate = atof(optarg);
+			break;
+		case 's':
+			free(socket_path);
+			socket_path = strdup(optarg);
+			break;
+		case 'S':
+			seed = strtoull(optarg, NULL, 10);
+			break;
+		case 'h':
+			fprintf(stdout, "%s", usage);
+			exit(EXIT_SUCCESS);
+		default:
+			fprintf(stderr, "%s", usage);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (connections <= 0 || duration <= 0 || rate < 0) {
+		fprintf(stderr, "%s", usage);
+		exit(EXIT_FAILURE);
+	}
+	if (!parse_mix(mix)) {
+		exit(EXIT_FAILURE);
+	}
+	free(mix);
+	bench.interval_ms = rate > 0 ? 1000.0 / rate : 0;
+
+	if (!socket_path) {
+		socket_path = get_socketpath();
+		if (!socket_path) {
+			sway_abort("Unable to retrieve socket path");
+		}
+	}
+
+	struct connection *conns = calloc(connections, sizeof(struct connection));
+	struct pollfd *pfds = calloc(connections, sizeof(struct pollfd));
+	if (!conns || !pfds) {
+		sway_abort("Unable to allocate connections");
+	}
+	double start = now_msec();
+	for (int i = 0; i < connections; ++i) {
+		conns[i].fd = ipc_open_socket(socket_path);
+		conns[i].alive = true;
+		// Seed each connection differently, but reproducibly
+		conns[i].rng = (seed + i) * 0x9E3779B97F4A7C15ULL | 1;
+		// Spread the first messages over one interval
+		conns[i].next_send_at = start + bench.interval_ms * i / connections;
+	}
+	free(socket_path);
+
+	double end = start + duration * 1000.0;
+	double now = start;
+	while (now < end) {
+		int alive = 0;
+		double next_deadline = end;
+		for (int i = 0; i < connections; ++i) {
+			struct connection *conn = &conns[i];
+			pfds[i].fd = conn->alive ? conn->fd : -1;
+			pfds[i].events = POLLIN;
+			pfds[i].revents = 0;
+			if (!conn->alive) {
+				continue;
+			}
+			++alive;
+			if (!conn->waiting) {
+				if (conn->next_send_at <= now) {
+					send_next(conn, now);
+				} else if (conn->next_send_at < next_deadline) {
+					next_deadline = conn->next_send_at;
+				}
+			}
+		}
+		if (!alive) {
+			fprintf(stderr, "All connections were closed by the server\n");
+			break;
+		}
+
+		int timeout = next_deadline > now ? (int)(next_deadline - now) : 0;
+		if (poll(pfds, connections, timeout) < 0 && errno != EINTR) {
+			sway_log_errno(SWAY_ERROR, "poll failed");
+			break;
+		}
+		for (int i = 0; i < connections; ++i) {
+			if (!conns[i].alive) {
+				continue;
+			}
+			if (pfds[i].revents & POLLIN) {
+				handle_readable(&conns[i]);
+			} else if (pfds[i].revents & (POLLHUP | POLLERR)) {
+				drop_connection(&conns[i]);
+			}
+		}
+		now = now_msec();
+	}
+
+	print_report(now - start, connections);
+
+	for (int i = 0; i < connections; ++i) {
+		if (conns[i].alive) {
+			close(conns[i].fd);
+		}
+	}
+	for (int i = 0; i < BENCH_MESSAGE_COUNT; ++i) {
+		free(bench.latencies[i].samples);
+	}
+	free(conns);
+	free(pfds);
+	return bench.disconnects > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <strings.h>
 #include <getopt.h>
+#include <poll.h>
 #include <stdint.h>
 #include <sys/un.h>
 #include <sys/socket.h>
@@ -321,16 +322,347 @@ static void pretty_print(int type, json_object *resp) {
 	}
 }
 
+static bool parse_message_type(const char *name, uint32_t *type) {
+	if (strcasecmp(name, "command") == 0) {
+		*type = IPC_COMMAND;
+	} else if (strcasecmp(name, "get_workspaces") == 0) {
+		*type = IPC_GET_WORKSPACES;
+	} else if (strcasecmp(name, "get_seats") == 0) {
+		*type = IPC_GET_SEATS;
+	} else if (strcasecmp(name, "get_memory") == 0) {
+		*type = IPC_GET_MEMORY;
+	} else if (strcasecmp(name, "dump_trace") == 0) {
+		*type = IPC_DUMP_TRACE;
+	} else if (strcasecmp(name, "get_inputs") == 0) {
+		*type = IPC_GET_INPUTS;
+	} else if (strcasecmp(name, "get_outputs") == 0) {
+		*type = IPC_GET_OUTPUTS;
+	} else if (strcasecmp(name, "get_tree") == 0) {
+		*type = IPC_GET_TREE;
+	} else if (strcasecmp(name, "get_marks") == 0) {
+		*type = IPC_GET_MARKS;
+	} else if (strcasecmp(name, "get_bar_config") == 0) {
+		*type = IPC_GET_BAR_CONFIG;
+	} else if (strcasecmp(name, "get_version") == 0) {
+		*type = IPC_GET_VERSION;
+	} else if (strcasecmp(name, "get_binding_modes") == 0) {
+		*type = IPC_GET_BINDING_MODES;
+	} else if (strcasecmp(name, "get_config") == 0) {
+		*type = IPC_GET_CONFIG;
+	} else if (strcasecmp(name, "send_tick") == 0) {
+		*type = IPC_SEND_TICK;
+	} else if (strcasecmp(name, "subscribe") == 0) {
+		*type = IPC_SUBSCRIBE;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/*
+ * In batch mode, requests are read from stdin and sent as soon as they are
+ * read, with up to BATCH_WINDOW of them waiting for their replies. Sway
+ * buffers the replies while we are busy printing and drops clients which fall
+ * a few megabytes behind, so no more requests are sent once the replies
+ * expected for those in flight reach BATCH_REPLY_BUDGET. A reply is expected
+ * to be as large as the largest one seen for its type. Until a type has been
+ * seen, its reply is assumed to use up the whole budget.
+ */
+#define BATCH_WINDOW 32
+#define BATCH_REPLY_BUDGET (512 * 1024)
+#define BATCH_REPLY_TYPES 32
+
+struct batch_request {
+	uint32_t type;
+	char *error; // Set for requests which were never sent
+	size_t expected_size;
+};
+
+struct batch_reply_size {
+	uint32_t type;
+	size_t size;
+};
+
+struct batch {
+	int socketfd;
+	bool raw, quiet;
+	bool failed;
+
+	char *input;
+	size_t input_len, input_size;
+	bool input_eof;
+
+	struct batch_request pending[BATCH_WINDOW];
+	size_t pending_start, pending_len;
+	size_t pending_size; // expected size of the replies in flight
+
+	struct batch_reply_size reply_sizes[BATCH_REPLY_TYPES];
+	size_t reply_sizes_len;
+};
+
+static size_t batch_expected_size(struct batch *batch, uint32_t type) {
+	for (size_t i = 0; i < batch->reply_sizes_len; ++i) {
+		if (batch->reply_sizes[i].type == type) {
+			return batch->reply_sizes[i].size;
+		}
+	}
+	return BATCH_REPLY_BUDGET;
+}
+
+static void batch_learn_size(struct batch *batch, uint32_t type,
+		size_t size) {
+	size += IPC_HEADER_SIZE;
+	for (size_t i = 0; i < batch->reply_sizes_len; ++i) {
+		if (batch->reply_sizes[i].type == type) {
+			if (size > batch->reply_sizes[i].size) {
+				batch->reply_sizes[i].size = size;
+			}
+			return;
+		}
+	}
+	if (batch->reply_sizes_len < BATCH_REPLY_TYPES) {
+		batch->reply_sizes[batch->reply_sizes_len].type = type;
+		batch->reply_sizes[batch->reply_sizes_len].size = size;
+		batch->reply_sizes_len++;
+	}
+}
+
+static bool batch_can_send(struct batch *batch) {
+	return batch->pending_len < BATCH_WINDOW &&
+		batch->pending_size < BATCH_REPLY_BUDGET;
+}
+
+static bool batch_print_reply(struct batch *batch, uint32_t type,
+		const char *payload, uint32_t size) {
+	if (batch->raw || batch->quiet) {
+		// Replies are only parsed when they might be failures. Anything
+		// which isn't one is written as received.
+		bool ok = true;
+		if (strstr(payload, "\"success\": false")) {
+			json_object *obj = json_tokener_parse(payload);
+			ok = obj && success(obj, true);
+			json_object_put(obj);
+		}
+		if (!batch->quiet) {
+			fwrite(payload, 1, size, stdout);
+			putchar('\n');
+		}
+		return ok;
+	}
+
+	json_object *obj = json_tokener_parse(payload);
+	if (obj == NULL) {
+		fprintf(stderr, "ERROR: Could not parse json response from ipc. "
+				"This is a bug in sway.\n");
+		return false;
+	}
+	bool ok = success(obj, true);
+	pretty_print(type, obj);
+	json_object_put(obj);
+	return ok;
+}
+
+/**
+ * Prints the replies of requests at the front of the queue which failed
+ * without being sent, so that replies stay in the order of the requests.
+ */
+static void batch_print_errors(struct batch *batch) {
+	while (batch->pending_len > 0) {
+		struct batch_request *req = &batch->pending[batch->pending_start];
+		if (!req->error) {
+			return;
+		}
+		json_object *result = json_object_new_object();
+		json_object_object_add(result, "success",
+				json_object_new_boolean(false));
+		json_object_object_add(result, "error",
+				json_object_new_string(req->error));
+		json_object *results = json_object_new_array();
+		json_object_array_add(results, result);
+		const char *json = json_object_to_json_string(results);
+		batch_print_reply(batch, IPC_COMMAND, json, strlen(json));
+		json_object_put(results);
+		batch->failed = true;
+
+		free(req->error);
+		req->error = NULL;
+		batch->pending_start = (batch->pending_start + 1) % BATCH_WINDOW;
+		batch->pending_len--;
+	}
+}
+
+static void batch_push(struct batch *batch, uint32_t type, char *error) {
+	size_t i = (batch->pending_start + batch->pending_len) % BATCH_WINDOW;
+	batch->pending[i].type = type;
+	batch->pending[i].error = error;
+	batch->pending[i].expected_size =
+		error ? 0 : batch_expected_size(batch, type);
+	batch->pending_size += batch->pending[i].expected_size;
+	batch->pending_len++;
+	batch_print_errors(batch);
+}
+
+/**
+ * Sends the request on a line of input, which is the message type followed
+ * by the payload.
+ */
+static void batch_handle_line(struct batch *batch, char *line) {
+	line += strspn(line, " \t");
+	if (!*line) {
+		return;
+	}
+	size_t name_len = strcspn(line, " \t");
+	char *payload = line + name_len;
+	if (*payload) {
+		*payload++ = '\0';
+		payload += strspn(payload, " \t");
+	}
+
+	uint32_t type;
+	if (!parse_message_type(line, &type)) {
+		size_t len = snprintf(NULL, 0, "Unknown message type %s", line) + 1;
+		char *error = malloc(len);
+		if (!error) {
+			sway_abort("Unable to allocate error message");
+		}
+		snprintf(error, len, "Unknown message type %s", line);
+		batch_push(batch, IPC_COMMAND, error);
+		return;
+	}
+	if (type == IPC_SUBSCRIBE) {
+		// The events would be mixed up with the replies
+		batch_push(batch, IPC_COMMAND,
+				strdup("Subscribe cannot be used in batch mode"));
+		return;
+	}
+	if (!ipc_send_message(batch->socketfd, type, payload, strlen(payload))) {
+		sway_abort("Unable to send IPC message");
+	}
+	batch_push(batch, type, NULL);
+}
+
+/**
+ * Returns the next complete line of input, or the remaining input once stdin
+ * is closed. The line is valid until more input is read.
+ */
+static char *batch_next_line(struct batch *batch, size_t *consumed) {
+	char *newline = memchr(batch->input, '\n', batch->input_len);
+	if (newline) {
+		*newline = '\0';
+		*consumed = newline - batch->input + 1;
+		return batch->input;
+	}
+	if (batch->input_eof && batch->input_len > 0) {
+		batch->input[batch->input_len] = '\0';
+		*consumed = batch->input_len;
+		return batch->input;
+	}
+	return NULL;
+}
+
+static void batch_read_input(struct batch *batch) {
+	if (batch->input_size - batch->input_len < 4096) {
+		batch->input_size *= 2;
+		batch->input = realloc(batch->input, batch->input_size);
+		if (!batch->input) {
+			sway_abort("Unable to allocate input buffer");
+		}
+	}
+	// Leave room for terminating the last line
+	ssize_t amt = read(STDIN_FILENO, batch->input + batch->input_len,
+			batch->input_size - batch->input_len - 1);
+	if (amt < 0) {
+		sway_abort("Unable to read from stdin");
+	}
+	if (amt == 0) {
+		batch->input_eof = true;
+	}
+	batch->input_len += amt;
+}
+
+static int run_batch(int socketfd, bool raw, bool quiet) {
+	struct batch batch = {
+		.socketfd = socketfd,
+		.raw = raw,
+		.quiet = quiet,
+		.input_size = 8192,
+	};
+	batch.input = malloc(batch.input_size);
+	if (!batch.input) {
+		sway_abort("Unable to allocate input buffer");
+	}
+
+	while (true) {
+		// Send everything already read, as far as the window allows
+		size_t consumed = 0;
+		char *line;
+		while (batch_can_send(&batch) &&
+				(line = batch_next_line(&batch, &consumed))) {
+			batch_handle_line(&batch, line);
+			batch.input_len -= consumed;
+			memmove(batch.input, batch.input + consumed, batch.input_len);
+		}
+		if (batch.input_eof && batch.input_len == 0 &&
+				batch.pending_len == 0) {
+			break;
+		}
+
+		// Only flush when about to wait, so bursts are written at once
+		fflush(stdout);
+
+		struct pollfd fds[] = {
+			{ .fd = socketfd, .events = POLLIN },
+			{ .fd = STDIN_FILENO, .events = POLLIN },
+		};
+		if (batch.pending_len == 0) {
+			fds[0].fd = -1;
+		}
+		if (batch.input_eof || !batch_can_send(&batch)) {
+			fds[1].fd = -1;
+		}
+		if (poll(fds, 2, -1) < 0) {
+			sway_abort("Unable to poll");
+		}
+
+		if (fds[0].revents) {
+			struct ipc_response *reply = ipc_recv_response(socketfd);
+			if (!reply) {
+				sway_abort("Unable to receive IPC response");
+			}
+			struct batch_request *req = &batch.pending[batch.pending_start];
+			batch.pending_size -= req->expected_size;
+			batch_learn_size(&batch, req->type, reply->size);
+			if (!batch_print_reply(&batch, req->type, reply->payload,
+						reply->size)) {
+				batch.failed = true;
+			}
+			free_ipc_response(reply);
+			batch.pending_start = (batch.pending_start + 1) % BATCH_WINDOW;
+			batch.pending_len--;
+			batch_print_errors(&batch);
+		}
+		if (fds[1].revents) {
+			batch_read_input(&batch);
+		}
+	}
+
+	fflush(stdout);
+	free(batch.input);
+	return batch.failed ? 1 : 0;
+}
+
 int main(int argc, char **argv) {
 	static bool quiet = false;
 	static bool raw = false;
 	static bool monitor = false;
+	static bool batch = false;
 	char *socket_path = NULL;
 	char *cmdtype = NULL;
 
 	sway_log_init(SWAY_INFO, NULL);
 
 	static struct option long_options[] = {
+		{"batch", no_argument, NULL, 'b'},
 		{"help", no_argument, NULL, 'h'},
 		{"monitor", no_argument, NULL, 'm'},
 		{"pretty", no_argument, NULL, 'p'},
@@ -345,6 +677,7 @@ int main(int argc, char **argv) {
 	const char *usage =
 		"Usage: swaymsg [options] [message]\n"
 		"\n"
+		"  -b, --batch            Send the messages read from stdin, one per line\n"
 		"  -h, --help             Show help message and quit.\n"
 		"  -m, --monitor          Monitor until killed (-t SUBSCRIBE only)\n"
 		"  -p, --pretty           Use pretty output even when not using a tty\n"
@@ -359,11 +692,14 @@ int main(int argc, char **argv) {
 	int c;
 	while (1) {
 		int option_index = 0;
-		c = getopt_long(argc, argv, "hmpqrs:t:v", long_options, &option_index);
+		c = getopt_long(argc, argv, "bhmpqrs:t:v", long_options, &option_index);
 		if (c == -1) {
 			break;
 		}
 		switch (c) {
+		case 'b': // Batch
+			batch = true;
+			break;
 		case 'm': // Monitor
 			monitor = true;
 			break;
@@ -406,34 +742,7 @@ int main(int argc, char **argv) {
 	}
 
 	uint32_t type = IPC_COMMAND;
-
-	if (strcasecmp(cmdtype, "command") == 0) {
-		type = IPC_COMMAND;
-	} else if (strcasecmp(cmdtype, "get_workspaces") == 0) {
-		type = IPC_GET_WORKSPACES;
-	} else if (strcasecmp(cmdtype, "get_seats") == 0) {
-		type = IPC_GET_SEATS;
-	} else if (strcasecmp(cmdtype, "get_inputs") == 0) {
-		type = IPC_GET_INPUTS;
-	} else if (strcasecmp(cmdtype, "get_outputs") == 0) {
-		type = IPC_GET_OUTPUTS;
-	} else if (strcasecmp(cmdtype, "get_tree") == 0) {
-		type = IPC_GET_TREE;
-	} else if (strcasecmp(cmdtype, "get_marks") == 0) {
-		type = IPC_GET_MARKS;
-	} else if (strcasecmp(cmdtype, "get_bar_config") == 0) {
-		type = IPC_GET_BAR_CONFIG;
-	} else if (strcasecmp(cmdtype, "get_version") == 0) {
-		type = IPC_GET_VERSION;
-	} else if (strcasecmp(cmdtype, "get_binding_modes") == 0) {
-		type = IPC_GET_BINDING_MODES;
-	} else if (strcasecmp(cmdtype, "get_config") == 0) {
-		type = IPC_GET_CONFIG;
-	} else if (strcasecmp(cmdtype, "send_tick") == 0) {
-		type = IPC_SEND_TICK;
-	} else if (strcasecmp(cmdtype, "subscribe") == 0) {
-		type = IPC_SUBSCRIBE;
-	} else {
+	if (!parse_message_type(cmdtype, &type)) {
 		if (quiet) {
 			exit(EXIT_FAILURE);
 		}
@@ -450,6 +759,24 @@ int main(int argc, char **argv) {
 		return 1;
 	}
 
+	if (batch) {
+		if (monitor || optind < argc) {
+			if (!quiet) {
+				sway_log(SWAY_ERROR, "Batch mode reads messages from stdin "
+						"and can't be used with a message or monitor");
+			}
+			free(socket_path);
+			return 1;
+		}
+		int socketfd = ipc_open_socket(socket_path);
+		struct timeval timeout = {.tv_sec = 3, .tv_usec = 0};
+		ipc_set_recv_timeout(socketfd, timeout);
+		int ret = run_batch(socketfd, raw, quiet);
+		close(socketfd);
+		free(socket_path);
+		return ret;
+	}
+
 	char *command = NULL;
 	if (optind < argc) {
 		command = join_args(argv + optind, argc - optind);
@@ -502,25 +829,35 @@ int main(int argc, char **argv) {
 				break;
 			}
 
-			json_object *obj = json_tokener_parse(reply->payload);
-			if (obj == NULL) {
-				if (!quiet) {
+			if (quiet) {
+				free_ipc_response(reply);
+				continue;
+			}
+
+			if (raw) {
+				// Events are serialized on a single line, so they can be
+				// passed through as is and still be line-delimited
+				fwrite(reply->payload, 1, reply->size, stdout);
+				putchar('\n');
+			} else {
+				json_object *obj = json_tokener_parse(reply->payload);
+				if (obj == NULL) {
 					fprintf(stderr, "ERROR: Could not parse json response from"
 							" ipc. This is a bug in sway.");
 					ret = 1;
+					free_ipc_response(reply);
+					break;
 				}
-				break;
-			} else if (quiet) {
+				printf("%s\n", json_object_to_json_string_ext(obj,
+					JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_SPACED));
 				json_object_put(obj);
-			} else {
-				if (raw) {
-					printf("%s\n", json_object_to_json_string(obj));
-				} else {
-					printf("%s\n", json_object_to_json_string_ext(obj,
-						JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_SPACED));
-				}
+			}
+
+			// Only flush once the events which already arrived are written,
+			// rather than once per event during bursts
+			struct pollfd pfd = { .fd = socketfd, .events = POLLIN };
+			if (poll(&pfd, 1, 0) <= 0) {
 				fflush(stdout);
-				json_object_put(obj);
 			}
 
 			free_ipc_response(reply);
@@ -1,7 +1,10 @@
 #define _POSIX_C_SOURCE 200809L
+#include <errno.h>
 #include <getopt.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wordexp.h>
 #include <unistd.h>
 #include "log.h"
@@ -11,26 +14,6 @@
 #include "util.h"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 
-static char *read_from_stdin(void) {
-	char *buffer = NULL;
-	size_t buffer_len = 0;
-	char *line = NULL;
-	size_t line_size = 0;
-	ssize_t nread;
-	while ((nread = getline(&line, &line_size, stdin)) != -1) {
-		buffer = realloc(buffer, buffer_len + nread + 1);
-		snprintf(&buffer[buffer_len], nread + 1, "%s", line);
-		buffer_len += nread;
-	}
-	free(line);
-
-	while (buffer && buffer[buffer_len - 1] == '\n') {
-		buffer[--buffer_len] = '\0';
-	}
-
-	return buffer;
-}
-
 int swaynag_parse_options(int argc, char **argv, struct swaynag *swaynag,
 		list_t *types, struct swaynag_type *type, char **config, bool *debug) {
 	enum type_options {
@@ -47,6 +30,7 @@ int swaynag_parse_options(int argc, char **argv, struct swaynag *swaynag,
 		TO_GAP_BTN_DISMISS,
 		TO_MARGIN_BTN_RIGHT,
 		TO_PADDING_BTN,
+		TO_DETAILED_MAX_SIZE,
 	};
 
 	static struct option opts[] = {
@@ -59,6 +43,8 @@ int swaynag_parse_options(int argc, char **argv, struct swaynag *swaynag,
 		{"help", no_argument, NULL, 'h'},
 		{"detailed-message", no_argument, NULL, 'l'},
 		{"detailed-button", required_argument, NULL, 'L'},
+		{"detailed-message-max-size", required_argument, NULL,
+			TO_DETAILED_MAX_SIZE},
 		{"message", required_argument, NULL, 'm'},
 		{"output", required_argument, NULL, 'o'},
 		{"dismiss-button", required_argument, NULL, 's'},
@@ -97,6 +83,8 @@ int swaynag_parse_options(int argc, char **argv, struct swaynag *swaynag,
 		"  -h, --help                    Show help message and quit.\n"
 		"  -l, --detailed-message        Read a detailed message from stdin.\n"
 		"  -L, --detailed-button <text>  Set the text of the detail button.\n"
+		"  --detailed-message-max-size <bytes>  Limit the detailed message "
+			"read from stdin.\n"
 		"  -m, --message <msg>           Set the message text.\n"
 		"  -o, --output <output>         Set the output to use.\n"
 		"  -s, --dismiss-button <text>   Set the dismiss button text.\n"
@@ -176,8 +164,12 @@ int swaynag_parse_options(int argc, char **argv, struct swaynag *swaynag,
 			break;
 		case 'l': // Detailed Message
 			if (swaynag) {
+				// Read by the event loop, so swaynag can be shown before the
+				// writer is done
 				free(swaynag->details.message);
-				swaynag->details.message = read_from_stdin();
+				swaynag->details.message = strdup("");
+				swaynag->details.message_len = 0;
+				swaynag->details.reading = true;
 				swaynag->details.button_up.text = strdup("▲");
 				swaynag->details.button_down.text = strdup("▼");
 			}
@@ -220,6 +212,22 @@ int swaynag_parse_options(int argc, char **argv, struct swaynag *swaynag,
 		case 'v': // Version
 			fprintf(stdout, "swaynag version " SWAY_VERSION "\n");
 			return -1;
+		case TO_DETAILED_MAX_SIZE: // Detailed message size limit
+			if (swaynag) {
+				char *end;
+				errno = 0;
+				unsigned long size = strtoul(optarg, &end, 0);
+				// strtoul accepts and negates a leading minus sign. Half of
+				// the address space leaves room for the truncation note.
+				if (!*optarg || *end || strchr(optarg, '-') || errno ||
+						size == 0 || size > SIZE_MAX / 2) {
+					fprintf(stderr, "Invalid detailed message max size: %s\n",
+							optarg);
+					return EXIT_FAILURE;
+				}
+				swaynag->details.max_size = size;
+			}
+			break;
 		case TO_COLOR_BACKGROUND: // Background color
 			if (type) {
 				type->background = parse_color(optarg);
@@ -27,6 +27,7 @@ int main(int argc, char **argv) {
 
 	memset(&swaynag, 0, sizeof(swaynag));
 	swaynag.buttons = create_list();
+	swaynag.details.max_size = SWAYNAG_DETAILS_MAX_SIZE;
 
 	struct swaynag_button *button_close =
 		calloc(sizeof(struct swaynag_button), 1);
@@ -96,13 +97,6 @@ int main(int argc, char **argv) {
 
 	swaynag_types_free(types);
 
-	if (swaynag.details.message) {
-		list_add(swaynag.buttons, swaynag.details.button_details);
-	} else {
-		free(swaynag.details.button_details->text);
-		free(swaynag.details.button_details);
-	}
-
 	sway_log(SWAY_DEBUG, "Output: %s", swaynag.type->output);
 	sway_log(SWAY_DEBUG, "Anchors: %d", swaynag.type->anchors);
 	sway_log(SWAY_DEBUG, "Type: %s", swaynag.type->name);
@@ -122,8 +116,6 @@ int main(int argc, char **argv) {
 
 cleanup:
 	swaynag_types_free(types);
-	free(swaynag.details.button_details->text);
-	free(swaynag.details.button_details);
 	swaynag_destroy(&swaynag);
 	return exit_code;
 }
@@ -1,8 +1,10 @@
 #include <stdint.h>
+#include <stdlib.h>
 #include "cairo.h"
 #include "log.h"
 #include "pango.h"
 #include "pool-buffer.h"
+#include "swaynag/render.h"
 #include "swaynag/swaynag.h"
 #include "swaynag/types.h"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
@@ -71,6 +73,93 @@ static int get_detailed_scroll_button_width(cairo_t *cairo,
 	return text_width + border * 2 + padding * 2;
 }
 
+struct swaynag_details_line {
+	PangoLayoutLine *line;
+	// In Pango units, relative to the top left of the layout
+	int x, y, height, baseline;
+};
+
+/**
+ * The details wrapped at some width, with an index of their lines so that
+ * scrolling only needs to draw the lines in view.
+ */
+struct swaynag_details_layout {
+	PangoLayout *layout;
+	int width;
+	int32_t scale;
+
+	struct swaynag_details_line *lines;
+	int line_count;
+	int height; // In Pango units
+};
+
+void render_details_invalidate(struct swaynag *swaynag) {
+	struct swaynag_details_layout *cached = swaynag->details.layout;
+	if (!cached) {
+		return;
+	}
+	g_object_unref(cached->layout);
+	free(cached->lines);
+	free(cached);
+	swaynag->details.layout = NULL;
+}
+
+static struct swaynag_details_layout *get_details_layout(cairo_t *cairo,
+		struct swaynag *swaynag, int width) {
+	struct swaynag_details_layout *cached = swaynag->details.layout;
+	if (cached && cached->width == width && cached->scale == swaynag->scale) {
+		return cached;
+	}
+	render_details_invalidate(swaynag);
+
+	cached = calloc(1, sizeof(struct swaynag_details_layout));
+	if (!cached) {
+		sway_log(SWAY_ERROR, "Failed to allocate details layout");
+		return NULL;
+	}
+	cached->width = width;
+	cached->scale = swaynag->scale;
+	// Only the complete lines read so far are shown
+	cached->layout = get_pango_layout(cairo, swaynag->type->font, "",
+			swaynag->scale, false);
+	pango_layout_set_text(cached->layout, swaynag->details.message,
+			swaynag->details.message_len);
+	pango_layout_set_width(cached->layout, width * PANGO_SCALE);
+	pango_layout_set_wrap(cached->layout, PANGO_WRAP_WORD_CHAR);
+	pango_layout_set_single_paragraph_mode(cached->layout, false);
+	pango_cairo_update_layout(cairo, cached->layout);
+
+	cached->line_count = pango_layout_get_line_count(cached->layout);
+	cached->lines = calloc(cached->line_count,
+			sizeof(struct swaynag_details_line));
+	if (!cached->lines) {
+		sway_log(SWAY_ERROR, "Failed to allocate details line index");
+		g_object_unref(cached->layout);
+		free(cached);
+		return NULL;
+	}
+	PangoLayoutIter *iter = pango_layout_get_iter(cached->layout);
+	int i = 0;
+	do {
+		struct swaynag_details_line *line = &cached->lines[i++];
+		PangoRectangle logical;
+		pango_layout_iter_get_line_extents(iter, NULL, &logical);
+		line->line = pango_layout_iter_get_line_readonly(iter);
+		line->x = logical.x;
+		line->y = logical.y;
+		line->height = logical.height;
+		line->baseline = pango_layout_iter_get_baseline(iter);
+	} while (i < cached->line_count && pango_layout_iter_next_line(iter));
+	pango_layout_iter_free(iter);
+
+	struct swaynag_details_line *last = &cached->lines[i - 1];
+	cached->line_count = i;
+	cached->height = last->y + last->height;
+
+	swaynag->details.layout = cached;
+	return cached;
+}
+
 static uint32_t render_detailed(cairo_t *cairo, struct swaynag *swaynag,
 		uint32_t y) {
 	uint32_t width = swaynag->width * swaynag->scale;
@@ -83,56 +172,51 @@ static uint32_t render_detailed(cairo_t *cairo, struct swaynag *swaynag,
 	swaynag->details.y = y * swaynag->scale + decor;
 	swaynag->details.width = width - decor * 2;
 
-	PangoLayout *layout = get_pango_layout(cairo, swaynag->type->font,
-			swaynag->details.message, swaynag->scale, false);
-	pango_layout_set_width(layout,
-			(swaynag->details.width - padding * 2) * PANGO_SCALE);
-	pango_layout_set_wrap(layout, PANGO_WRAP_WORD_CHAR);
-	pango_layout_set_single_paragraph_mode(layout, false);
-	pango_cairo_update_layout(cairo, layout);
-	swaynag->details.total_lines = pango_layout_get_line_count(layout);
-
-	PangoLayoutLine *line;
-	line = pango_layout_get_line_readonly(layout, swaynag->details.offset);
-	gint offset = line->start_index;
-	const char *text = pango_layout_get_text(layout);
-	pango_layout_set_text(layout, text + offset, strlen(text) - offset);
-
-	int text_width, text_height;
-	pango_cairo_update_layout(cairo, layout);
-	pango_layout_get_pixel_size(layout, &text_width, &text_height);
-
-	bool show_buttons = swaynag->details.offset > 0;
 	int button_width = get_detailed_scroll_button_width(cairo, swaynag);
+	int max_text_height = SWAYNAG_MAX_HEIGHT - swaynag->details.y
+		- decor - padding * 2;
+	int text_width = swaynag->details.width - padding * 2;
+
+	// Scrolling is only possible when the text overflows, and a layout wrapped
+	// around the buttons is only kept when it did, so either means the buttons
+	// are needed without having to lay out the text at full width again
+	struct swaynag_details_layout *cached = swaynag->details.layout;
+	bool show_buttons = swaynag->details.offset > 0 || (cached &&
+			cached->scale == swaynag->scale &&
+			cached->width == text_width - button_width);
+	cached = get_details_layout(cairo, swaynag,
+			show_buttons ? text_width - button_width : text_width);
+	if (cached && !show_buttons &&
+			cached->height > max_text_height * PANGO_SCALE) {
+		show_buttons = true;
+		cached = get_details_layout(cairo, swaynag, text_width - button_width);
+	}
+	if (!cached) {
+		return y;
+	}
 	if (show_buttons) {
 		swaynag->details.width -= button_width;
-		pango_layout_set_width(layout,
-				(swaynag->details.width - padding * 2) * PANGO_SCALE);
 	}
 
-	uint32_t ideal_height;
-	do {
-		ideal_height = swaynag->details.y + text_height + decor + padding * 2;
-		if (ideal_height > SWAYNAG_MAX_HEIGHT) {
-			ideal_height = SWAYNAG_MAX_HEIGHT;
-
-			if (!show_buttons) {
-				show_buttons = true;
-				swaynag->details.width -= button_width;
-				pango_layout_set_width(layout,
-						(swaynag->details.width - padding * 2) * PANGO_SCALE);
-			}
-		}
-
-		swaynag->details.height = ideal_height - swaynag->details.y - decor;
-		pango_layout_set_height(layout,
-				(swaynag->details.height - padding * 2) * PANGO_SCALE);
-		pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
-		pango_cairo_update_layout(cairo, layout);
-		pango_layout_get_pixel_size(layout, &text_width, &text_height);
-	} while (text_height != (swaynag->details.height - padding * 2));
+	if (swaynag->details.offset >= cached->line_count) {
+		swaynag->details.offset = cached->line_count - 1;
+	}
+	int first = swaynag->details.offset;
+	int top = cached->lines[first].y;
+	int end = first + 1;
+	while (end < cached->line_count && cached->lines[end].y +
+			cached->lines[end].height - top <= max_text_height * PANGO_SCALE) {
+		++end;
+	}
+	swaynag->details.total_lines = cached->line_count;
+	swaynag->details.visible_lines = end - first;
 
-	swaynag->details.visible_lines = pango_layout_get_line_count(layout);
+	uint32_t ideal_height = SWAYNAG_MAX_HEIGHT;
+	if (!show_buttons) {
+		int text_height = PANGO_PIXELS_CEIL(cached->height);
+		ideal_height = swaynag->details.y + text_height + decor + padding * 2;
+	}
+	swaynag->details.height = ideal_height - swaynag->details.y - decor;
 
 	if (show_buttons) {
 		swaynag->details.button_up.x =
@@ -158,11 +242,15 @@ static uint32_t render_detailed(cairo_t *cairo, struct swaynag *swaynag,
 			swaynag->details.width, swaynag->details.height);
 	cairo_fill(cairo);
 
-	cairo_move_to(cairo, swaynag->details.x + padding,
-			swaynag->details.y + padding);
 	cairo_set_source_u32(cairo, swaynag->type->text);
-	pango_cairo_show_layout(cairo, layout);
-	g_object_unref(layout);
+	for (int i = first; i < end; ++i) {
+		struct swaynag_details_line *line = &cached->lines[i];
+		cairo_move_to(cairo,
+				swaynag->details.x + padding + pango_units_to_double(line->x),
+				swaynag->details.y + padding +
+				pango_units_to_double(line->baseline - top));
+		pango_cairo_show_layout_line(cairo, line->line);
+	}
 
 	return ideal_height / swaynag->scale;
 }
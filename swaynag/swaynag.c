@@ -1,6 +1,9 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
 #include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -8,6 +11,7 @@
 #include <wayland-cursor.h>
 #include "log.h"
 #include "list.h"
+#include "loop.h"
 #include "swaynag/render.h"
 #include "swaynag/swaynag.h"
 #include "swaynag/types.h"
@@ -420,12 +424,155 @@ void swaynag_setup(struct swaynag *swaynag) {
 	wl_registry_destroy(registry);
 }
 
+static void details_render(void *data) {
+	struct swaynag *swaynag = data;
+	swaynag->details.render_timer = NULL;
+	render_details_invalidate(swaynag);
+	if (swaynag->details.visible) {
+		render_frame(swaynag);
+	}
+}
+
+/**
+ * Makes the complete lines read so far visible. Lines are only shown once
+ * complete, so that a multibyte character split between reads is never
+ * passed to Pango.
+ */
+static void details_update(struct swaynag *swaynag) {
+	struct swaynag_details *details = &swaynag->details;
+	size_t len = details->read_len;
+	if (details->reading) {
+		char *newline = NULL;
+		for (size_t i = len; i > details->message_len; --i) {
+			if (details->message[i - 1] == '\n') {
+				newline = &details->message[i - 1];
+				break;
+			}
+		}
+		if (!newline) {
+			return;
+		}
+		len = newline - details->message;
+	}
+	while (len > 0 && details->message[len - 1] == '\n') {
+		--len;
+	}
+	if (len == details->message_len) {
+		return;
+	}
+	details->message_len = len;
+
+	if (list_find(swaynag->buttons, details->button_details) == -1) {
+		// Only offer to toggle the details once there are some to show
+		list_add(swaynag->buttons, details->button_details);
+		render_frame(swaynag);
+	}
+
+	// Laying out the details is linear in their length, so only do it once
+	// per burst of input
+	if (!details->reading) {
+		if (details->render_timer) {
+			loop_remove_timer(swaynag->eventloop, details->render_timer);
+		}
+		details_render(swaynag);
+	} else if (!details->render_timer) {
+		details->render_timer = loop_add_timer(swaynag->eventloop, 50,
+				details_render, swaynag);
+	}
+}
+
+#define DETAILS_NOTE_SIZE 16
+
+static void details_truncate(struct swaynag *swaynag) {
+	struct swaynag_details *details = &swaynag->details;
+	const char note[] = "\n[truncated]\n";
+	size_t len = details->read_len;
+	while (len > 0 && details->message[len - 1] != '\n') {
+		--len;
+	}
+	// The buffer always has room for the note
+	const char *text = len > 0 ? note : note + 1;
+	memcpy(details->message + len, text, strlen(text) + 1);
+	details->read_len = len + strlen(text);
+	details->truncated = true;
+	sway_log(SWAY_INFO, "Detailed message truncated to %zu bytes",
+			details->max_size);
+}
+
+static void details_in(int fd, short mask, void *data) {
+	struct swaynag *swaynag = data;
+	struct swaynag_details *details = &swaynag->details;
+
+	// Once the limit is reached, the rest is still read so that the writer
+	// doesn't block, but thrown away
+	char discard[4096];
+	char *buf = discard;
+	size_t size = sizeof(discard);
+	if (!details->truncated && details->read_len < details->max_size) {
+		if (details->read_size < details->read_len + 4096 + DETAILS_NOTE_SIZE) {
+			size_t new_size = details->read_size ? details->read_size * 2 :
+				64 * 1024;
+			if (new_size > details->max_size + DETAILS_NOTE_SIZE) {
+				new_size = details->max_size + DETAILS_NOTE_SIZE;
+			}
+			char *message = realloc(details->message, new_size);
+			if (!message) {
+				sway_log(SWAY_ERROR, "Unable to allocate detailed message");
+				loop_remove_fd(swaynag->eventloop, fd);
+				details->reading = false;
+				details_update(swaynag);
+				return;
+			}
+			details->message = message;
+			details->read_size = new_size;
+		}
+		buf = details->message + details->read_len;
+		size = details->read_size - details->read_len - DETAILS_NOTE_SIZE;
+	}
+
+	ssize_t amt = read(fd, buf, size);
+	if (amt < 0 && (errno == EINTR || errno == EAGAIN)) {
+		return;
+	}
+	if (amt <= 0) {
+		if (amt < 0) {
+			sway_log_errno(SWAY_ERROR, "Unable to read detailed message");
+		}
+		loop_remove_fd(swaynag->eventloop, fd);
+		details->reading = false;
+	} else if (buf != discard) {
+		details->read_len += amt;
+		details->message[details->read_len] = '\0';
+	} else if (!details->truncated) {
+		details_truncate(swaynag);
+	}
+	details_update(swaynag);
+}
+
+static void display_in(int fd, short mask, void *data) {
+	struct swaynag *swaynag = data;
+	if (wl_display_dispatch(swaynag->display) == -1) {
+		swaynag->run_display = false;
+	}
+}
+
 void swaynag_run(struct swaynag *swaynag) {
 	swaynag->run_display = true;
 	render_frame(swaynag);
-	while (swaynag->run_display
-			&& wl_display_dispatch(swaynag->display) != -1) {
-		// This is intentionally left blank
+
+	swaynag->eventloop = loop_create();
+	loop_add_fd(swaynag->eventloop, wl_display_get_fd(swaynag->display),
+			POLLIN, display_in, swaynag);
+	if (swaynag->details.reading) {
+		loop_add_fd(swaynag->eventloop, STDIN_FILENO, POLLIN,
+				details_in, swaynag);
+	}
+	while (swaynag->run_display) {
+		errno = 0;
+		if (wl_display_flush(swaynag->display) == -1 && errno != EAGAIN) {
+			break;
+		}
+		loop_poll(swaynag->eventloop);
 	}
 
 	if (swaynag->display) {
@@ -437,6 +584,11 @@ void swaynag_destroy(struct swaynag *swaynag) {
 	swaynag->run_display = false;
 
 	free(swaynag->message);
+	if (swaynag->details.button_details &&
+			list_find(swaynag->buttons, swaynag->details.button_details) == -1) {
+		free(swaynag->details.button_details->text);
+		free(swaynag->details.button_details);
+	}
 	for (int i = 0; i < swaynag->buttons->length; ++i) {
 		struct swaynag_button *button = swaynag->buttons->items[i];
 		free(button->text);
@@ -444,6 +596,10 @@ void swaynag_destroy(struct swaynag *swaynag) {
 		free(button);
 	}
 	list_free(swaynag->buttons);
+	if (swaynag->eventloop) {
+		loop_destroy(swaynag->eventloop);
+	}
+	render_details_invalidate(swaynag);
 	free(swaynag->details.message);
 	free(swaynag->details.button_up.text);
 	free(swaynag->details.button_down.text);